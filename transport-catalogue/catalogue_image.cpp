@@ -0,0 +1,211 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catalogue_image.h"
+#include "checksum.h"
+#include "mapped_file.h"
+
+namespace ctlg {
+
+namespace {
+
+using namespace std::literals;
+
+// Раскладка образа: заголовок, затем разделы в порядке полей заголовка.
+// Размер каждого раздела кратен 8 байтам, поэтому записи выровнены.
+//   StopRecord[stop_count], BusRecord[bus_count], StopId[route_stop_count],
+//   DistanceRecord[distance_count], char[names_size]
+constexpr char MAGIC[8] = {'T', 'C', 'I', 'M', 'A', 'G', 'E', '\0'};
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    //сумма по всему, что следует за заголовком
+    uint64_t checksum;
+    uint64_t payload_size;
+    uint32_t stop_count;
+    uint32_t bus_count;
+    uint64_t route_stop_count;
+    uint64_t distance_count;
+    uint64_t names_size;
+};
+
+struct StopRecord {
+    double lat;
+    double lng;
+    uint64_t name_offset;
+    uint32_t name_size;
+    uint32_t reserved;
+};
+
+struct BusRecord {
+    uint64_t name_offset;
+    //начало остановок маршрута в общем массиве id
+    uint64_t stops_offset;
+    uint32_t name_size;
+    uint32_t stop_count;
+    uint32_t is_round;
+    uint32_t reserved;
+};
+
+struct DistanceRecord {
+    StopId from;
+    StopId to;
+    int32_t dist;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ImageHeader) % 8 == 0);
+static_assert(sizeof(StopRecord) % 8 == 0);
+static_assert(sizeof(BusRecord) % 8 == 0);
+static_assert(sizeof(DistanceRecord) % 8 == 0);
+
+size_t AlignUp(size_t size) {
+    return (size + 7) & ~size_t{7};
+}
+
+template <typename T>
+void Append(std::string& buffer, const T* items, size_t count) {
+    buffer.append(reinterpret_cast<const char*>(items), count * sizeof(T));
+    buffer.resize(AlignUp(buffer.size()), '\0');
+}
+
+void Check(bool condition, const char* what) {
+    if (!condition) {
+        throw std::runtime_error("CatalogueImage::Load: "s + what);
+    }
+}
+
+} //namespace
+
+void CatalogueImage::Save(const TransportCatalogue& catalogue, std::ostream& out) {
+    std::string names;
+    std::vector<StopRecord> stops;
+    std::vector<BusRecord> buses;
+    std::vector<StopId> route_stops;
+    std::vector<DistanceRecord> distances;
+
+    for (const Stop& stop : catalogue.all_stops_) {
+        stops.push_back({stop.coord_.lat, stop.coord_.lng, names.size(),
+                         static_cast<uint32_t>(stop.name_.size()), 0});
+        names += stop.name_;
+    }
+    for (const Bus& bus : catalogue.all_buses_) {
+        if (bus.removed_) {
+            continue;
+        }
+        buses.push_back({names.size(), route_stops.size(), static_cast<uint32_t>(bus.name_.size()),
+                         static_cast<uint32_t>(bus.stops_.size()), bus.is_round_ ? 1u : 0u, 0});
+        names += bus.name_;
+        route_stops.insert(route_stops.end(), bus.stops_.begin(), bus.stops_.end());
+    }
+    catalogue.distances_.ForEachExplicit([&distances](StopId from, StopId to, int dist) {
+        distances.push_back({from, to, dist, 0});
+    });
+
+    std::string payload;
+    Append(payload, stops.data(), stops.size());
+    Append(payload, buses.data(), buses.size());
+    Append(payload, route_stops.data(), route_stops.size());
+    Append(payload, distances.data(), distances.size());
+    Append(payload, names.data(), names.size());
+
+    ImageHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.header_size = sizeof(ImageHeader);
+    header.checksum = Checksum(payload.data(), payload.size());
+    header.payload_size = payload.size();
+    header.stop_count = static_cast<uint32_t>(stops.size());
+    header.bus_count = static_cast<uint32_t>(buses.size());
+    header.route_stop_count = route_stops.size();
+    header.distance_count = distances.size();
+    header.names_size = names.size();
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+    if (!out) {
+        throw std::runtime_error("CatalogueImage::Save: write failed.");
+    }
+}
+
+std::unique_ptr<TransportCatalogue> CatalogueImage::Load(const std::string& path) {
+    auto file = std::make_shared<const MappedFile>(path);
+    Check(file->Size() >= sizeof(ImageHeader), "file is too short.");
+    ImageHeader header;
+    std::memcpy(&header, file->Data(), sizeof(header));
+    Check(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0, "not a catalogue image.");
+    Check(header.version == VERSION && header.header_size == sizeof(ImageHeader), "unsupported image version.");
+    Check(header.payload_size == file->Size() - sizeof(ImageHeader), "truncated image.");
+
+    const size_t stops_size = AlignUp(header.stop_count * sizeof(StopRecord));
+    const size_t buses_size = AlignUp(header.bus_count * sizeof(BusRecord));
+    const size_t route_stops_size = AlignUp(header.route_stop_count * sizeof(StopId));
+    const size_t distances_size = AlignUp(header.distance_count * sizeof(DistanceRecord));
+    Check(stops_size + buses_size + route_stops_size + distances_size + AlignUp(header.names_size)
+          == header.payload_size, "inconsistent section sizes.");
+
+    const char* payload = file->Data() + sizeof(ImageHeader);
+    Check(Checksum(payload, header.payload_size) == header.checksum, "checksum mismatch.");
+
+    const char* pos = payload;
+    auto stops = reinterpret_cast<const StopRecord*>(pos);
+    pos += stops_size;
+    auto buses = reinterpret_cast<const BusRecord*>(pos);
+    pos += buses_size;
+    auto route_stops = reinterpret_cast<const StopId*>(pos);
+    pos += route_stops_size;
+    auto distances = reinterpret_cast<const DistanceRecord*>(pos);
+    pos += distances_size;
+    const char* names = pos;
+    auto name = [&](uint64_t offset, uint32_t size) {
+        Check(offset <= header.names_size && size <= header.names_size - offset, "name out of range.");
+        return string_view{names + offset, size};
+    };
+
+    auto catalogue = std::make_unique<TransportCatalogue>();
+    TransportCatalogue& db = *catalogue;
+    db.stops_index_.reserve(header.stop_count);
+    db.stop_buses_.resize(header.stop_count);
+    for (uint32_t id = 0; id < header.stop_count; ++id) {
+        const StopRecord& record = stops[id];
+        Stop& stop = db.all_stops_.emplace_back(name(record.name_offset, record.name_size),
+                                                geo::Coordinates{record.lat, record.lng});
+        stop.id_ = id;
+        db.stops_index_.insert({stop.name_, id});
+        db.stop_points_.Add(stop.coord_);
+    }
+
+    db.distances_.Reserve(header.distance_count * 2);
+    for (uint64_t i = 0; i < header.distance_count; ++i) {
+        const DistanceRecord& record = distances[i];
+        Check(record.from < header.stop_count && record.to < header.stop_count, "stop id out of range.");
+        db.distances_.Set(record.from, record.to, record.dist);
+    }
+
+    db.buses_index_.reserve(header.bus_count);
+    for (uint32_t id = 0; id < header.bus_count; ++id) {
+        const BusRecord& record = buses[id];
+        Check(record.stops_offset <= header.route_stop_count
+              && record.stop_count <= header.route_stop_count - record.stops_offset, "route out of range.");
+        const StopId* first = route_stops + record.stops_offset;
+        vector<StopId> route(first, first + record.stop_count);
+        for (StopId stop : route) {
+            Check(stop < header.stop_count, "stop id out of range.");
+        }
+        Bus& bus = db.all_buses_.emplace_back(name(record.name_offset, record.name_size),
+                                              std::move(route), record.is_round != 0);
+        bus.id_ = id;
+        db.BuildBusDistances(bus);
+        db.buses_index_.insert({bus.name_, id});
+        db.AddBusToStops(bus);
+    }
+
+    db.image_ = std::move(file);
+    return catalogue;
+}
+
+} //ctlg
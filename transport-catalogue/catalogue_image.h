@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "transport_catalogue.h"
+
+namespace ctlg {
+
+// Двоичный образ загруженного справочника: остановки с координатами, маршруты
+// в виде массивов id остановок, явно заданные дорожные расстояния и все имена.
+// Образ снабжён версией и контрольной суммой. При загрузке файл отображается
+// в память только для чтения, и имена справочника указывают прямо в него,
+// поэтому JSON не разбирается, а строки не копируются.
+class CatalogueImage {
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    // удалённые автобусы в образ не попадают
+    static void Save(const TransportCatalogue& catalogue, std::ostream& out);
+    // бросает std::runtime_error, если файл не является образом этой версии или повреждён
+    static std::unique_ptr<TransportCatalogue> Load(const std::string& path);
+};
+
+} //ctlg
@@ -0,0 +1,66 @@
+#include <sstream>
+
+#include "catalogue_snapshot.h"
+
+namespace ctlg {
+
+CatalogueSnapshot::CatalogueSnapshot(std::unique_ptr<TransportCatalogue> catalogue,
+                                     RoutingSettings routing_settings,
+                                     renderer::RenderSettings render_settings):
+    CatalogueSnapshot(std::move(catalogue), routing_settings, std::move(render_settings), std::string{}) {
+}
+
+CatalogueSnapshot::CatalogueSnapshot(std::unique_ptr<TransportCatalogue> catalogue,
+                                     RoutingSettings routing_settings,
+                                     renderer::RenderSettings render_settings,
+                                     const std::string& routes_path):
+    catalogue_(Prepare(std::move(catalogue))),
+    router_(*catalogue_, routing_settings),
+    render_settings_(std::move(render_settings)) {
+    if(routes_path.empty()){
+        router_.CreateAllData();
+    } else {
+        router_.AttachRoutes(routes_path);
+    }
+}
+
+std::unique_ptr<const TransportCatalogue> CatalogueSnapshot::Prepare(std::unique_ptr<TransportCatalogue> catalogue) {
+    catalogue->UpdateBusStats();
+    if(!catalogue->IsFrozen()){
+        catalogue->Freeze();
+    }
+    return catalogue;
+}
+
+const std::string& CatalogueSnapshot::GetMap() const {
+    std::call_once(map_once_, [this]{
+        map_ = RenderMap(std::nullopt);
+        map_rendered_.store(true, std::memory_order_release);
+    });
+    return map_;
+}
+
+const std::string* CatalogueSnapshot::GetRenderedMap() const {
+    return map_rendered_.load(std::memory_order_acquire) ? &map_ : nullptr;
+}
+
+std::string CatalogueSnapshot::RenderMap(geo::Coordinates min, geo::Coordinates max) const {
+    return RenderMap(renderer::Viewport{min, max, catalogue_->GetStopsInArea(min, max)});
+}
+
+std::string CatalogueSnapshot::RenderMap(const std::optional<renderer::Viewport>& viewport) const {
+    vector<std::pair<string_view, const Bus*>> routes;
+    for(string_view bus_name : catalogue_->GetBuses()){
+        routes.push_back({bus_name, catalogue_->GetBus(bus_name)});
+    }
+    renderer::MapRenderer renderer{render_settings_};
+    renderer.SetRoutes(routes, catalogue_->GetAllStops());
+    if(viewport){
+        renderer.SetViewport(*viewport);
+    }
+    std::stringstream ss;
+    renderer.RenderMap().Render(ss);
+    return ss.str();
+}
+
+} //ctlg
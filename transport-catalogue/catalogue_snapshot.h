@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "domain.h"
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+namespace ctlg {
+
+// Неизменяемый снимок справочника вместе с производными данными: маршрутизатором
+// и отрисованной картой. Все методы константные и могут вызываться из любых потоков.
+class CatalogueSnapshot {
+public:
+    // catalogue должен быть полностью загружен; снимок замораживает его и строит граф маршрутов
+    CatalogueSnapshot(std::unique_ptr<TransportCatalogue> catalogue,
+                      RoutingSettings routing_settings,
+                      renderer::RenderSettings render_settings);
+    // то же, но при непустом routes_path таблица маршрутов не строится, а подключается
+    // из файла, сохранённого transport_router::SaveRoutes для того же справочника
+    CatalogueSnapshot(std::unique_ptr<TransportCatalogue> catalogue,
+                      RoutingSettings routing_settings,
+                      renderer::RenderSettings render_settings,
+                      const std::string& routes_path);
+    CatalogueSnapshot(const CatalogueSnapshot&) = delete;
+    CatalogueSnapshot& operator=(const CatalogueSnapshot&) = delete;
+
+    const TransportCatalogue& GetCatalogue() const { return *catalogue_; }
+    const transport_router& GetRouter() const { return router_; }
+    // SVG-карта, отрисовывается при первом обращении
+    const std::string& GetMap() const;
+    // уже отрисованная карта или nullptr, если к ней ещё не обращались
+    const std::string* GetRenderedMap() const;
+    // карта только области [min, max], отрисовывается на каждый вызов
+    std::string RenderMap(geo::Coordinates min, geo::Coordinates max) const;
+
+private:
+    std::unique_ptr<const TransportCatalogue> catalogue_;
+    transport_router router_;
+    renderer::RenderSettings render_settings_;
+    mutable std::once_flag map_once_;
+    mutable std::string map_;
+    mutable std::atomic<bool> map_rendered_{false};
+
+    //досчитывает статистику и замораживает справочник; дальше он только читается
+    static std::unique_ptr<const TransportCatalogue> Prepare(std::unique_ptr<TransportCatalogue> catalogue);
+    std::string RenderMap(const std::optional<renderer::Viewport>& viewport) const;
+};
+
+// Точка публикации текущего снимка. Читатели получают снимок и работают с ним
+// без блокировок справочника; писатель строит новый снимок целиком и подменяет
+// указатель атомарно. Старый снимок освобождается, когда его отпустит последний читатель.
+class SnapshotHolder {
+public:
+    std::shared_ptr<const CatalogueSnapshot> Get() const {
+        return std::atomic_load(&current_);
+    }
+    void Publish(std::shared_ptr<const CatalogueSnapshot> snapshot) {
+        std::atomic_store(&current_, std::move(snapshot));
+    }
+
+private:
+    std::shared_ptr<const CatalogueSnapshot> current_;
+};
+
+} //ctlg
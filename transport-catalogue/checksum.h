@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ctlg {
+
+constexpr uint64_t CHECKSUM_SEED = 0xcbf29ce484222325ULL;
+
+//добавляет к контрольной сумме hash одно 8-байтовое слово
+inline uint64_t MixChecksum(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+    return hash ^ (hash >> 32);
+}
+
+//контрольная сумма по 8-байтовым словам; size кратен 8
+inline uint64_t Checksum(const char* data, size_t size, uint64_t hash = CHECKSUM_SEED) {
+    for (size_t pos = 0; pos < size; pos += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + pos, 8);
+        hash = MixChecksum(hash, word);
+    }
+    return hash;
+}
+
+} //ctlg
@@ -0,0 +1,82 @@
+#include "distance_table.h"
+
+namespace ctlg {
+
+//финализатор splitmix64: перемешивает биты обоих идентификаторов
+size_t DistanceTable::Hash(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return static_cast<size_t>(key);
+}
+
+//индекс ячейки с ключом key либо первой пустой ячейки на её пути
+size_t DistanceTable::FindIndex(uint64_t key) const {
+    const size_t mask = slots_.size() - 1;
+    size_t index = Hash(key) & mask;
+    while (slots_[index].key != key && slots_[index].key != EMPTY_KEY) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+void DistanceTable::Rehash(size_t capacity) {
+    std::vector<Slot> old = std::move(slots_);
+    slots_.assign(capacity, Slot{});
+    for (const Slot& slot : old) {
+        if (slot.key != EMPTY_KEY) {
+            slots_[FindIndex(slot.key)] = slot;
+        }
+    }
+}
+
+void DistanceTable::Reserve(size_t count) {
+    size_t capacity = slots_.empty() ? 16 : slots_.size();
+    while (count * 2 > capacity) {
+        capacity *= 2;
+    }
+    if (capacity != slots_.size()) {
+        Rehash(capacity);
+    }
+}
+
+DistanceTable::Slot& DistanceTable::Insert(uint64_t key) {
+    //заполненность таблицы не превышает половины
+    if ((size_ + 1) * 2 > slots_.size()) {
+        Rehash(slots_.empty() ? 16 : slots_.size() * 2);
+    }
+    Slot& slot = slots_[FindIndex(key)];
+    if (slot.key == EMPTY_KEY) {
+        slot.key = key;
+        ++size_;
+    }
+    return slot;
+}
+
+void DistanceTable::Set(StopId from, StopId to, int dist) {
+    Slot& direct = Insert(MakeKey(from, to));
+    direct.dist = dist;
+    direct.is_explicit = true;
+    if (from == to) {
+        return;
+    }
+    Slot& back = Insert(MakeKey(to, from));
+    if (!back.is_explicit) {
+        back.dist = dist;
+    }
+}
+
+std::optional<int> DistanceTable::Get(StopId from, StopId to) const {
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    const Slot& slot = slots_[FindIndex(MakeKey(from, to))];
+    if (slot.key == EMPTY_KEY) {
+        return std::nullopt;
+    }
+    return slot.dist;
+}
+
+} //ctlg
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "domain.h"
+#include "memory_usage.h"
+
+namespace ctlg {
+
+// Таблица дорожных расстояний между остановками с открытой адресацией.
+// Ключ - пара идентификаторов остановок, упакованная в 64 бита.
+// Расстояние, заданное для одного направления, используется и для обратного,
+// пока обратное не задано явно, поэтому поиск выполняется одним проходом.
+class DistanceTable {
+public:
+    void Set(StopId from, StopId to, int dist);
+    std::optional<int> Get(StopId from, StopId to) const;
+    size_t Size() const { return size_; }
+    MemoryUsage GetMemoryUsage() const { return UsageOf(slots_); }
+    //готовит таблицу к count записям без промежуточных перестроений
+    void Reserve(size_t count);
+
+    //f(from, to, dist) для расстояний, заданных явно
+    template <typename Func>
+    void ForEachExplicit(Func f) const {
+        for (const Slot& slot : slots_) {
+            if (slot.key != EMPTY_KEY && slot.is_explicit) {
+                f(static_cast<StopId>(slot.key >> 32), static_cast<StopId>(slot.key), slot.dist);
+            }
+        }
+    }
+
+private:
+    static constexpr uint64_t EMPTY_KEY = ~uint64_t{0};
+
+    struct Slot {
+        uint64_t key = EMPTY_KEY;
+        int dist = 0;
+        bool is_explicit = false;
+    };
+
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+
+    static uint64_t MakeKey(StopId from, StopId to) {
+        return (uint64_t{from} << 32) | to;
+    }
+    static size_t Hash(uint64_t key);
+    size_t FindIndex(uint64_t key) const;
+    Slot& Insert(uint64_t key);
+    void Rehash(size_t capacity);
+};
+
+} //ctlg
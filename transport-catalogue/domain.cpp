@@ -45,23 +45,73 @@ bool Bus::IsRound() const{
 }
 
 size_t Bus::GetLastStopIndex() const {
-    return stops_.size() / 2;
+    return stops_.empty() ? 0 : stops_.size() - 1;
 }
 
-Stop* Bus::GetLastStop() const {
+size_t Bus::GetRouteStopCount() const {
+    if(IsRound() || stops_.empty()){
+        return stops_.size();
+    }
+    return stops_.size() * 2 - 1;
+}
+
+StopId Bus::GetRouteStop(size_t index) const {
+    if(index < stops_.size()){
+        return stops_[index];
+    }
+    return stops_[GetRouteStopCount() - 1 - index];
+}
+
+ranges::Range<RouteIterator> Bus::GetRoute() const {
+    return {RouteIterator{this, 0}, RouteIterator{this, GetRouteStopCount()}};
+}
+
+StopId RouteIterator::operator*() const {
+    return bus_->GetRouteStop(index_);
+}
+
+StopId Bus::GetLastStop() const {
     return stops_[GetLastStopIndex()];
 }
 
-bool Bus::IsEndStop(Stop* stop) const{
+bool Bus::IsEndStop(StopId stop) const{
     if(IsRound()){
         return stop == stops_[0];
     } else {
-        Stop* last_stop = GetLastStop();
+        StopId last_stop = GetLastStop();
         return stop == stops_[0] || stop == last_stop;
     }
 }
 
-size_t Bus::GetStopIndex(Stop* stop) const{
+namespace {
+//накопленное от начала маршрута значение для позиции index последовательности GetRoute();
+//на обратном пути к длине пути туда добавляется пройденная часть обратного
+template <typename T>
+T RoutePrefix(const vector<T>& forward, const vector<T>& back, size_t index) {
+    const size_t n = forward.size();
+    if(n == 0){
+        return T{};
+    }
+    if(index < n){
+        return forward[index];
+    }
+    const size_t mirror = 2 * (n - 1) - index;
+    return forward[n - 1] + (back[n - 1] - back[mirror]);
+}
+}
+
+int Bus::GetRoadDistance(size_t from_index, size_t to_index) const {
+    return RoutePrefix(road_prefix_, road_back_prefix_, to_index)
+        - RoutePrefix(road_prefix_, road_back_prefix_, from_index);
+}
+
+double Bus::GetGeoDistance(size_t from_index, size_t to_index) const {
+    //географическое расстояние обратного пути совпадает с прямым
+    return RoutePrefix(geo_prefix_, geo_prefix_, to_index)
+        - RoutePrefix(geo_prefix_, geo_prefix_, from_index);
+}
+
+size_t Bus::GetStopIndex(StopId stop) const{
     for(size_t i = 0; i < stops_.size(); ++i){
         if( stop == stops_[i]){
             return i;
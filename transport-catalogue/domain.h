@@ -1,51 +1,108 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "geo.h"
 #include "graph.h"
+#include "ranges.h"
 
 using std::string, std::vector, std::string_view;
 using namespace std::literals;
 
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// name_ у остановок и автобусов, добавленных в справочник, указывает
+// в его хранилище имён; до добавления - на строку, переданную в конструктор
 struct Stop{
-    Stop(string name, geo::Coordinates&& coord): 
-        name_(std::move(name)),
+    Stop(string_view name, geo::Coordinates&& coord): 
+        name_(name),
         coord_(std::move(coord))
     {  }
-    string name_;
+    string_view name_;
     geo::Coordinates coord_;
+    //порядковый номер остановки в справочнике, назначается при добавлении
+    StopId id_ = 0;
+};
+
+struct BusStat {
+    string_view name;
+    size_t stops;
+    size_t unique_stops;
+    double lenght_geo;
+    int lenght;
+};
+
+struct Bus;
+
+// Итератор по остановкам маршрута в порядке проезда. Для некольцевого маршрута,
+// у которого хранится только путь в одну сторону, возвращает путь туда и обратно
+class RouteIterator {
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = StopId;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const StopId*;
+    using reference = StopId;
+
+    RouteIterator(const Bus* bus, size_t index): bus_(bus), index_(index) {}
+    StopId operator*() const;
+    RouteIterator& operator++() { ++index_; return *this; }
+    bool operator==(const RouteIterator& other) const { return index_ == other.index_; }
+    bool operator!=(const RouteIterator& other) const { return index_ != other.index_; }
+private:
+    const Bus* bus_;
+    size_t index_;
 };
 
 struct Bus {
-    Bus(string&& name, vector<Stop*>&& stops, bool is_round):
-        name_(std::move(name)), stops_(std::move(stops)), is_round_(is_round)
+    Bus(string_view name, vector<StopId>&& stops, bool is_round):
+        name_(name), stops_(std::move(stops)), is_round_(is_round)
     {}
-    string name_;
-    vector<Stop*> stops_;
+    string_view name_;
+    //для некольцевого маршрута - только путь от первой до конечной остановки
+    vector<StopId> stops_;
     bool is_round_;
+    //порядковый номер автобуса в справочнике, назначается при добавлении
+    BusId id_ = 0;
+    //удалённый автобус остаётся в справочнике без остановок, чтобы не сдвигать id
+    bool removed_ = false;
+    //накопленные от первой остановки дорожное и географическое расстояния,
+    //road_prefix_[i] - расстояние до остановки stops_[i]
+    vector<int> road_prefix_;
+    vector<double> geo_prefix_;
+    //для некольцевого маршрута: накопленные дорожные расстояния обратного пути,
+    //road_back_prefix_[i] - сумма расстояний stops_[m + 1] -> stops_[m] для m < i
+    vector<int> road_back_prefix_;
+    //статистика маршрута, сбрасывается при изменении остановок или расстояний
+    std::optional<BusStat> stat_;
+    //индексы - позиции в последовательности GetRoute(), from_index <= to_index
+    int GetRoadDistance(size_t from_index, size_t to_index) const;
+    double GetGeoDistance(size_t from_index, size_t to_index) const;
+    //число остановок на маршруте с учётом обратного пути
+    size_t GetRouteStopCount() const;
+    StopId GetRouteStop(size_t index) const;
+    ranges::Range<RouteIterator> GetRoute() const;
     bool IsRound() const;
     size_t GetLastStopIndex() const;
-    Stop* GetLastStop() const;
-    bool IsEndStop(Stop* stop) const;
-    size_t GetStopIndex(Stop* stop) const;
+    StopId GetLastStop() const;
+    bool IsEndStop(StopId stop) const;
+    size_t GetStopIndex(StopId stop) const;
 };
 
-using StopPtr = Stop*;
-using BusPtr = Bus*;
+using StopPtr = const Stop*;
+using BusPtr = const Bus*;
 
-struct StopStat {
-    string name;
-    vector<string_view> buses;
-};
+using BusNamesRange = ranges::Range<vector<string_view>::const_iterator>;
 
-struct BusStat {
-    string name;
-    size_t stops;
-    size_t unique_stops;
-    double lenght_geo;
-    int lenght;
+struct StopStat {
+    string_view name;
+    BusNamesRange buses;
 };
 
 struct RoutingSettings{
@@ -0,0 +1,79 @@
+#include <algorithm>
+
+#include "geo.h"
+
+namespace geo{
+
+namespace {
+    const double EARTH_RADIUS = 6371000;
+    const double DR = 3.1415926535 / 180.;
+}
+
+void PointsSoA::Add(Coordinates point) {
+    lat_.push_back(point.lat);
+    lng_.push_back(point.lng);
+    sin_lat_.push_back(std::sin(point.lat * DR));
+    cos_lat_.push_back(std::cos(point.lat * DR));
+}
+
+void PointsSoA::Set(size_t index, Coordinates point) {
+    lat_[index] = point.lat;
+    lng_[index] = point.lng;
+    sin_lat_[index] = std::sin(point.lat * DR);
+    cos_lat_[index] = std::cos(point.lat * DR);
+}
+
+// Расчёт идёт в два прохода: сначала нужные значения собираются в плотные массивы,
+// затем считаются без ветвлений и обращений по индексам - такой цикл компилятор
+// может векторизовать, а без векторизации он остаётся обычным скалярным.
+void PointsSoA::ComputeSegments(const uint32_t* indexes, size_t count, double* out, SegmentScratch& scratch,
+                                DistanceMode mode) const {
+    if (count < 2) {
+        return;
+    }
+    const size_t n = count - 1;
+    for (std::vector<double>* column : {&scratch.dlng, &scratch.dlat, &scratch.sin1, &scratch.sin2,
+                                        &scratch.cos1, &scratch.cos2}) {
+        column->resize(n);
+    }
+    scratch.same.resize(n);
+    double* dlng = scratch.dlng.data();
+    double* dlat = scratch.dlat.data();
+    double* sin1 = scratch.sin1.data();
+    double* sin2 = scratch.sin2.data();
+    double* cos1 = scratch.cos1.data();
+    double* cos2 = scratch.cos2.data();
+    char* same = scratch.same.data();
+    for (size_t i = 0; i < n; ++i) {
+        const uint32_t a = indexes[i];
+        const uint32_t b = indexes[i + 1];
+        dlng[i] = std::abs(lng_[a] - lng_[b]);
+        dlat[i] = lat_[b] - lat_[a];
+        sin1[i] = sin_lat_[a];
+        sin2[i] = sin_lat_[b];
+        cos1[i] = cos_lat_[a];
+        cos2[i] = cos_lat_[b];
+        same[i] = lat_[a] == lat_[b] && lng_[a] == lng_[b];
+    }
+    if (mode == DistanceMode::EXACT) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = std::acos(sin1[i] * sin2[i] + cos1[i] * cos2[i] * std::cos(dlng[i] * DR))
+                * EARTH_RADIUS;
+        }
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            //косинус средней широты заменён средним косинусов
+            const double x = dlng[i] * DR * (cos1[i] + cos2[i]) * 0.5;
+            const double y = dlat[i] * DR;
+            out[i] = std::sqrt(x * x + y * y) * EARTH_RADIUS;
+        }
+    }
+    //совпадающие точки, как и в ComputeDistance, дают ровно 0
+    for (size_t i = 0; i < n; ++i) {
+        if (same[i]) {
+            out[i] = 0;
+        }
+    }
+}
+
+} //geo
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "memory_usage.h"
 
 namespace geo{
     struct Coordinates {
@@ -25,4 +29,47 @@ namespace geo{
             * 6371000;
     }
 
+    enum class DistanceMode {
+        // то же значение, что и ComputeDistance
+        EXACT,
+        // равнопромежуточная проекция без тригонометрии: относительная погрешность
+        // не более 1e-4 для отрезков до 100 км на широтах от -70 до 70 градусов
+        FAST,
+    };
+
+    // Рабочие массивы PointsSoA::ComputeSegments. Живут у вызывающего и переиспользуются,
+    // поэтому повторные вызовы не выделяют память
+    struct SegmentScratch {
+        std::vector<double> dlng;
+        std::vector<double> dlat;
+        std::vector<double> sin1;
+        std::vector<double> sin2;
+        std::vector<double> cos1;
+        std::vector<double> cos2;
+        std::vector<char> same;
+    };
+
+    // Координаты набора точек в виде структуры массивов с заранее вычисленными
+    // синусом и косинусом широты, чтобы пакетный расчёт расстояний
+    // не вызывал sin/cos для каждого отрезка
+    class PointsSoA {
+    public:
+        void Add(Coordinates point);
+        void Set(size_t index, Coordinates point);
+        size_t Size() const { return lat_.size(); }
+        MemoryUsage GetMemoryUsage() const {
+            return UsageOf(lat_) + UsageOf(lng_) + UsageOf(sin_lat_) + UsageOf(cos_lat_);
+        }
+
+        // out[i] - расстояние между точками indexes[i] и indexes[i + 1], i < count - 1
+        void ComputeSegments(const uint32_t* indexes, size_t count, double* out, SegmentScratch& scratch,
+                             DistanceMode mode = DistanceMode::EXACT) const;
+
+    private:
+        std::vector<double> lat_;
+        std::vector<double> lng_;
+        std::vector<double> sin_lat_;
+        std::vector<double> cos_lat_;
+    };
+
 } //geo
\ No newline at end of file
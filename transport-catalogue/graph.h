@@ -1,6 +1,7 @@
 #pragma once
 
 #include "domain.h"
+#include "memory_usage.h"
 #include "ranges.h"
 
 #include <cstdlib>
@@ -36,6 +37,7 @@ public:
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+    MemoryUsage GetMemoryUsage() const;
 
 private:
     std::vector<Edge<Weight>> edges_;
@@ -65,6 +67,15 @@ size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
     return edges_.size();
 }
 
+template <typename Weight>
+MemoryUsage DirectedWeightedGraph<Weight>::GetMemoryUsage() const {
+    MemoryUsage usage = UsageOf(edges_) + UsageOf(incidence_lists_);
+    for (const IncidenceList& list : incidence_lists_) {
+        usage += UsageOf(list);
+    }
+    return usage;
+}
+
 template <typename Weight>
 const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
     return edges_.at(edge_id);
@@ -3,13 +3,17 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
+#include "memory_usage.h"
+
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
+// сравнение прозрачное: ключ ищется по std::string_view без временной строки
+using Dict = std::map<std::string, Node, std::less<>>;
 using Array = std::vector<Node>;
 
 class ParsingError : public std::runtime_error {
@@ -140,8 +144,21 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+// Разбирает первое JSON-значение из text; всё, что следует за ним, игнорируется
+Document Load(std::string_view text);
+// Читает input до конца и разбирает его как Load(string_view)
 Document Load(std::istream& input);
+// Весь оставшийся текст потока. Читает блоками через rdbuf, а не посимвольно:
+// у std::cin, синхронизированного с stdio, каждый символ - отдельный вызов getc
+std::string ReadAll(std::istream& input);
+
+// PRETTY - с переводами строк и отступом в 4 пробела, COMPACT - без пробельных символов
+enum class PrintStyle { PRETTY, COMPACT };
+
+// Выводит документ через json::Writer, блоками
+void Print(const Document& doc, std::ostream& output, PrintStyle style = PrintStyle::PRETTY);
 
-void Print(const Document& doc, std::ostream& output);
+// Память, занятая деревом документа (без самого объекта Document)
+MemoryUsage GetMemoryUsage(const Document& doc);
 
 }  // namespace json
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "json_compact.h"
+#include "json_sax.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace json::compact {
+
+using namespace std::literals;
+
+DocumentBuilder::DocumentBuilder(std::string_view text, Document& doc)
+    : text_(text)
+    , doc_(doc) {
+}
+
+void DocumentBuilder::Reserve(size_t value_count) {
+    doc_.slots_.reserve(value_count);
+    doc_.keys_.reserve(value_count);
+}
+
+void DocumentBuilder::Null() {
+    Push(Slot{});
+}
+
+void DocumentBuilder::Bool(bool value) {
+    Slot slot;
+    slot.type = Type::BOOL;
+    slot.bool_value = value;
+    Push(slot);
+}
+
+void DocumentBuilder::Int(int value) {
+    Slot slot;
+    slot.type = Type::INT;
+    slot.int_value = value;
+    Push(slot);
+}
+
+void DocumentBuilder::Double(double value) {
+    Slot slot;
+    slot.type = Type::DOUBLE;
+    slot.double_value = value;
+    Push(slot);
+}
+
+void DocumentBuilder::String(std::string_view value) {
+    value = Store(value);
+    Slot slot;
+    slot.type = Type::STRING;
+    slot.str = {value.data(), value.size()};
+    Push(slot);
+}
+
+void DocumentBuilder::StartArray() {
+    Open();
+}
+
+void DocumentBuilder::EndArray() {
+    Close(Type::ARRAY);
+}
+
+void DocumentBuilder::StartDict() {
+    Open();
+}
+
+void DocumentBuilder::Key(std::string_view key) {
+    key_ = Store(key);
+}
+
+void DocumentBuilder::EndDict() {
+    SortDict(open_.back().mark);
+    Close(Type::DICT);
+}
+
+void DocumentBuilder::Finish() {
+    doc_.slots_.push_back(stack_.back());
+    doc_.keys_.push_back({});
+    stack_.clear();
+    stack_keys_.clear();
+}
+
+void DocumentBuilder::Clear() {
+    doc_.slots_.clear();
+    doc_.keys_.clear();
+    doc_.decoded_.clear();
+    stack_.clear();
+    stack_keys_.clear();
+    open_.clear();
+    key_ = {};
+}
+
+void DocumentBuilder::Push(const Slot& slot) {
+    stack_.push_back(slot);
+    stack_keys_.push_back(key_);
+    key_ = {};
+}
+
+void DocumentBuilder::Open() {
+    open_.push_back({stack_.size(), key_});
+    key_ = {};
+}
+
+void DocumentBuilder::Close(Type type) {
+    const OpenContainer container = open_.back();
+    open_.pop_back();
+    const Slot slot = CloseContainer(type, container.mark);
+    key_ = container.key;
+    Push(slot);
+}
+
+// Строка вне входного буфера раскодирована во временный буфер разбора
+// и сохраняется в документе, остальные указывают в буфер
+std::string_view DocumentBuilder::Store(std::string_view str) {
+    const std::less<const char*> before;
+    if (str.empty() || (!before(str.data(), text_.data())
+                        && !before(text_.data() + text_.size(), str.data() + str.size()))) {
+        return str;
+    }
+    return doc_.decoded_.emplace_back(str);
+}
+
+// Переносит детей контейнера со стека, начиная с mark, в документ
+DocumentBuilder::Slot DocumentBuilder::CloseContainer(Type type, size_t mark) {
+    Slot slot;
+    slot.type = type;
+    slot.first = static_cast<uint32_t>(doc_.slots_.size());
+    slot.count = static_cast<uint32_t>(stack_.size() - mark);
+    doc_.slots_.insert(doc_.slots_.end(), stack_.begin() + mark, stack_.end());
+    doc_.keys_.insert(doc_.keys_.end(), stack_keys_.begin() + mark, stack_keys_.end());
+    stack_.resize(mark);
+    stack_keys_.resize(mark);
+    return slot;
+}
+
+void DocumentBuilder::SortDict(size_t mark) {
+    const size_t count = stack_.size() - mark;
+    if (count < 2) {
+        return;
+    }
+    sorted_.clear();
+    for (size_t i = mark; i < stack_.size(); ++i) {
+        sorted_.push_back({stack_keys_[i], stack_[i]});
+    }
+    std::sort(sorted_.begin(), sorted_.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0 && sorted_[i].first == sorted_[i - 1].first) {
+            throw ParsingError("Duplicate key '"s + std::string(sorted_[i].first) + "' have been found");
+        }
+        stack_keys_[mark + i] = sorted_[i].first;
+        stack_[mark + i] = sorted_[i].second;
+    }
+}
+
+bool Node::IsNull() const {
+    return doc_->At(index_).type == Document::Type::NUL;
+}
+
+bool Node::IsBool() const {
+    return doc_->At(index_).type == Document::Type::BOOL;
+}
+
+bool Node::IsInt() const {
+    return doc_->At(index_).type == Document::Type::INT;
+}
+
+bool Node::IsDouble() const {
+    return IsInt() || IsPureDouble();
+}
+
+bool Node::IsPureDouble() const {
+    return doc_->At(index_).type == Document::Type::DOUBLE;
+}
+
+bool Node::IsString() const {
+    return doc_->At(index_).type == Document::Type::STRING;
+}
+
+bool Node::IsArray() const {
+    return doc_->At(index_).type == Document::Type::ARRAY;
+}
+
+bool Node::IsDict() const {
+    return doc_->At(index_).type == Document::Type::DICT;
+}
+
+bool Node::AsBool() const {
+    if (!IsBool()) {
+        throw std::logic_error("Not a bool"s);
+    }
+    return doc_->At(index_).bool_value;
+}
+
+int Node::AsInt() const {
+    if (!IsInt()) {
+        throw std::logic_error("Not an int"s);
+    }
+    return doc_->At(index_).int_value;
+}
+
+double Node::AsDouble() const {
+    if (IsInt()) {
+        return doc_->At(index_).int_value;
+    }
+    if (!IsPureDouble()) {
+        throw std::logic_error("Not a double"s);
+    }
+    return doc_->At(index_).double_value;
+}
+
+std::string_view Node::AsString() const {
+    if (!IsString()) {
+        throw std::logic_error("Not a string"s);
+    }
+    const auto& str = doc_->At(index_).str;
+    return {str.data, str.size};
+}
+
+Array Node::AsArray() const {
+    if (!IsArray()) {
+        throw std::logic_error("Not an array"s);
+    }
+    const Document::Slot& slot = doc_->At(index_);
+    return {doc_, slot.first, slot.count};
+}
+
+Dict Node::AsDict() const {
+    if (!IsDict()) {
+        throw std::logic_error("Not a dict"s);
+    }
+    const Document::Slot& slot = doc_->At(index_);
+    return {doc_, slot.first, slot.count};
+}
+
+json::Node Node::ToNode() const {
+    switch (doc_->At(index_).type) {
+        case Document::Type::NUL:
+            return nullptr;
+        case Document::Type::BOOL:
+            return AsBool();
+        case Document::Type::INT:
+            return AsInt();
+        case Document::Type::DOUBLE:
+            return AsDouble();
+        case Document::Type::STRING:
+            return std::string(AsString());
+        case Document::Type::ARRAY: {
+            json::Array result;
+            result.reserve(AsArray().size());
+            for (Node item : AsArray()) {
+                result.push_back(item.ToNode());
+            }
+            return result;
+        }
+        case Document::Type::DICT: {
+            json::Dict result;
+            for (const auto& [key, value] : AsDict()) {
+                result.emplace_hint(result.end(), std::string(key), value.ToNode());
+            }
+            return result;
+        }
+    }
+    return nullptr;
+}
+
+Dict::value_type Dict::Iterator::operator*() const {
+    return {doc_->keys_[index_], Node{doc_, index_}};
+}
+
+Dict::Iterator Dict::find(std::string_view key) const {
+    const auto& keys = doc_->keys_;
+    auto first = keys.begin() + first_;
+    auto last = first + count_;
+    auto it = std::lower_bound(first, last, key);
+    if (it == last || *it != key) {
+        return end();
+    }
+    return {doc_, static_cast<uint32_t>(it - keys.begin())};
+}
+
+Node Dict::at(std::string_view key) const {
+    Iterator it = find(key);
+    if (it == end()) {
+        throw std::out_of_range("json::compact::Dict::at: no key "s + std::string(key));
+    }
+    return (*it).second;
+}
+
+Node Document::GetRoot() const {
+    if (slots_.empty()) {
+        static const Document empty = [] {
+            Document doc;
+            doc.slots_.emplace_back();
+            doc.keys_.emplace_back();
+            return doc;
+        }();
+        return {&empty, 0};
+    }
+    return {this, static_cast<uint32_t>(slots_.size() - 1)};
+}
+
+MemoryUsage Document::GetMemoryUsage() const {
+    MemoryUsage usage = UsageOf(slots_) + UsageOf(keys_) + UsageOf(decoded_);
+    for (const std::pmr::string& str : decoded_) {
+        usage += UsageOf(str);
+    }
+    if (owned_text_) {
+        usage += MemoryUsage{sizeof(std::string), 1} + UsageOf(*owned_text_);
+    }
+    return usage;
+}
+
+Document Load(std::string_view text, std::pmr::memory_resource* resource) {
+    Document doc{resource};
+    DocumentBuilder builder{text, doc};
+    sax::Parse(text, builder);
+    builder.Finish();
+    return doc;
+}
+
+Document LoadElements(std::string_view elements, std::pmr::memory_resource* resource) {
+    Document doc{resource};
+    DocumentBuilder builder{elements, doc};
+    sax::ParseElements(elements, builder);
+    builder.Finish();
+    return doc;
+}
+
+Document Load(std::istream& input, std::pmr::memory_resource* resource) {
+    auto text = std::make_unique<const std::string>(ReadAll(input));
+    Document doc = Load(std::string_view{*text}, resource);
+    doc.owned_text_ = std::move(text);
+    return doc;
+}
+
+}  // namespace json::compact
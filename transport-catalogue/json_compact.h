@@ -0,0 +1,261 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "json.h"
+#include "memory_usage.h"
+
+// Компактный DOM только для чтения. Узлы хранятся подряд в одном векторе и
+// ссылаются на детей по индексам, словарь - отсортированный по ключу участок
+// этого вектора. Строки без экранирования не копируются, а указывают во входной
+// буфер, поэтому буфер должен жить не меньше документа (кроме Load(istream),
+// где документ владеет прочитанным текстом). Интерфейс повторяет json::Node,
+// но строки и ключи возвращаются как std::string_view.
+// Вся память документа берётся из переданного memory_resource: с monotonic_buffer_resource
+// разбор не обращается к общему распределителю, а документ освобождается одним release().
+namespace json::compact {
+
+class Document;
+class Array;
+class Dict;
+
+class Node {
+public:
+    bool IsNull() const;
+    bool IsBool() const;
+    bool IsInt() const;
+    // целое число тоже считается double
+    bool IsDouble() const;
+    bool IsPureDouble() const;
+    bool IsString() const;
+    bool IsArray() const;
+    bool IsDict() const;
+
+    bool AsBool() const;
+    int AsInt() const;
+    double AsDouble() const;
+    std::string_view AsString() const;
+    Array AsArray() const;
+    Dict AsDict() const;
+
+    // копия поддерева в виде обычного json::Node
+    json::Node ToNode() const;
+
+private:
+    friend class Array;
+    friend class Dict;
+    friend class Document;
+
+    Node(const Document* doc, uint32_t index): doc_(doc), index_(index) {}
+
+    const Document* doc_;
+    uint32_t index_;
+};
+
+class Array {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Node;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Node;
+
+        Iterator(const Document* doc, uint32_t index): doc_(doc), index_(index) {}
+        Node operator*() const { return {doc_, index_}; }
+        Iterator& operator++() { ++index_; return *this; }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+    private:
+        const Document* doc_;
+        uint32_t index_;
+    };
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    Node operator[](size_t i) const { return {doc_, static_cast<uint32_t>(first_ + i)}; }
+    Iterator begin() const { return {doc_, first_}; }
+    Iterator end() const { return {doc_, first_ + count_}; }
+
+private:
+    friend class Node;
+    Array(const Document* doc, uint32_t first, uint32_t count): doc_(doc), first_(first), count_(count) {}
+
+    const Document* doc_;
+    uint32_t first_;
+    uint32_t count_;
+};
+
+class Dict {
+public:
+    using value_type = std::pair<std::string_view, Node>;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Dict::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const Document* doc, uint32_t index): doc_(doc), index_(index) {}
+        value_type operator*() const;
+        Iterator& operator++() { ++index_; return *this; }
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const Iterator& other) const { return index_ != other.index_; }
+    private:
+        const Document* doc_;
+        uint32_t index_;
+    };
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    // бросает std::out_of_range, если ключа нет
+    Node at(std::string_view key) const;
+    Iterator find(std::string_view key) const;
+    size_t count(std::string_view key) const { return find(key) != end() ? 1 : 0; }
+    // ключи по возрастанию
+    Iterator begin() const { return {doc_, first_}; }
+    Iterator end() const { return {doc_, first_ + count_}; }
+
+private:
+    friend class Node;
+    Dict(const Document* doc, uint32_t first, uint32_t count): doc_(doc), first_(first), count_(count) {}
+
+    const Document* doc_;
+    uint32_t first_;
+    uint32_t count_;
+};
+
+class Document {
+public:
+    explicit Document(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : slots_(resource)
+        , keys_(resource)
+        , decoded_(resource) {
+    }
+    Document(Document&&) = default;
+    Document& operator=(Document&&) = default;
+    Document(const Document&) = delete;
+    Document& operator=(const Document&) = delete;
+
+    // пустой документ возвращает null
+    Node GetRoot() const;
+    MemoryUsage GetMemoryUsage() const;
+
+private:
+    friend class Node;
+    friend class Dict;
+    friend class Dict::Iterator;
+    friend class DocumentBuilder;
+    friend Document Load(std::istream& input, std::pmr::memory_resource* resource);
+
+    enum class Type : uint8_t { NUL, BOOL, INT, DOUBLE, STRING, ARRAY, DICT };
+
+    struct Slot {
+        Type type = Type::NUL;
+        bool bool_value = false;
+        // число элементов массива или словаря
+        uint32_t count = 0;
+        union {
+            int int_value;
+            double double_value;
+            // первый элемент массива или словаря
+            uint32_t first;
+            struct {
+                const char* data;
+                size_t size;
+            } str;
+        };
+        Slot(): double_value(0) {}
+    };
+
+    std::pmr::vector<Slot> slots_;
+    // ключ узла, если он значение словаря; параллелен slots_
+    std::pmr::vector<std::string_view> keys_;
+    // строки, в которых было экранирование
+    std::pmr::deque<std::pmr::string> decoded_;
+    // прочитанный из потока текст, на который указывают строки
+    std::unique_ptr<const std::string> owned_text_;
+
+    const Slot& At(uint32_t index) const { return slots_[index]; }
+};
+
+// Обработчик событий json::sax, собирающий компактный документ doc. Строки,
+// лежащие в text, документ не копирует, остальные сохраняет у себя.
+// Узлы собираются на стеке. Когда массив или словарь закрывается, его дети
+// переносятся со стека в документ одним участком, а на стеке остаётся сам контейнер.
+// Поэтому дети любого контейнера лежат в документе подряд, а корень - последним.
+// Повторный ключ словаря - ParsingError
+class DocumentBuilder {
+public:
+    DocumentBuilder(std::string_view text, Document& doc);
+
+    //узлы и ключи выделяются один раз, без перекладывания при росте
+    void Reserve(size_t value_count);
+    void Null();
+    void Bool(bool value);
+    void Int(int value);
+    void Double(double value);
+    void String(std::string_view value);
+    void StartArray();
+    void EndArray();
+    void StartDict();
+    void Key(std::string_view key);
+    void EndDict();
+
+    // после корневого значения: делает его корнем документа
+    void Finish();
+    // очищает документ, сохраняя выделенную память, для сборки следующего
+    void Clear();
+
+private:
+    using Slot = Document::Slot;
+    using Type = Document::Type;
+
+    // открытый контейнер: начало его детей на стеке и его собственный ключ
+    struct OpenContainer {
+        size_t mark;
+        std::string_view key;
+    };
+
+    std::string_view text_;
+    Document& doc_;
+    std::vector<Slot> stack_;
+    std::vector<std::string_view> stack_keys_;
+    std::vector<OpenContainer> open_;
+    //ключ следующего значения словаря
+    std::string_view key_;
+    //буфер для сортировки словаря
+    std::vector<std::pair<std::string_view, Slot>> sorted_;
+
+    void Push(const Slot& slot);
+    void Open();
+    void Close(Type type);
+    std::string_view Store(std::string_view str);
+    Slot CloseContainer(Type type, size_t mark);
+    void SortDict(size_t mark);
+};
+
+// Разбирает первое JSON-значение из text; строки документа указывают в text
+Document Load(std::string_view text,
+              std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+// Читает input до конца; документ владеет прочитанным текстом
+Document Load(std::istream& input,
+              std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+// Разбирает элементы массива, записанные через запятую без скобок, например часть
+// большого массива. Корень документа - массив из них
+Document LoadElements(std::string_view elements,
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+}  // namespace json::compact
@@ -0,0 +1,161 @@
+#include "json_parallel.h"
+#include "json_scan.h"
+
+#include <algorithm>
+#include <future>
+
+namespace json::compact {
+
+namespace {
+
+// Расположение массива в тексте: скобки и запятые между его элементами
+struct ArrayLayout {
+    size_t open = 0;
+    size_t close = 0;
+    std::vector<size_t> commas;
+};
+
+// Обходит структурные символы вне строк, начиная с позиции from, и передаёт f
+// позицию и символ; открывающая кавычка строки тоже передаётся. f возвращает
+// false, чтобы остановить обход
+template <typename F>
+void ForEachStructural(std::string_view text, const detail::StructuralIndex& index, size_t from, F f) {
+    const std::vector<uint32_t>& positions = index.positions;
+    auto it = std::lower_bound(positions.begin(), positions.end(), from);
+    bool in_string = false;
+    for (; it != positions.end(); ++it) {
+        const char c = text[*it];
+        if (in_string) {
+            // экранированная кавычка или косая черта стоит в индексе сразу следом
+            if (c == '\\' && std::next(it) != positions.end() && *std::next(it) == *it + 1) {
+                ++it;
+            } else if (c == '"') {
+                in_string = false;
+            }
+            continue;
+        }
+        in_string = c == '"';
+        if (!f(*it, c)) {
+            return;
+        }
+    }
+}
+
+std::optional<ArrayLayout> FindRootArray(std::string_view text, const detail::StructuralIndex& index,
+                                         std::string_view key) {
+    const char* begin = text.data();
+    const char* root = detail::SkipWhitespace(begin, begin + text.size());
+    if (root == begin + text.size() || *root != '{') {
+        return std::nullopt;
+    }
+    // ищем "key": на глубине корневого словаря
+    int depth = 0;
+    bool expect_key = false;
+    bool key_found = false;
+    size_t value = text.size();
+    ForEachStructural(text, index, static_cast<size_t>(root - begin), [&](size_t pos, char c) {
+        switch (c) {
+            case '{':
+            case '[':
+                ++depth;
+                expect_key = depth == 1;
+                break;
+            case '}':
+            case ']':
+                --depth;
+                return depth > 0;
+            case ',':
+                expect_key = depth == 1;
+                break;
+            case '"':
+                if (expect_key) {
+                    key_found = text.substr(pos + 1, key.size()) == key
+                        && pos + 1 + key.size() < text.size() && text[pos + 1 + key.size()] == '"';
+                    expect_key = false;
+                }
+                break;
+            case ':':
+                if (depth == 1 && key_found) {
+                    value = static_cast<size_t>(detail::SkipWhitespace(begin + pos + 1, begin + text.size()) - begin);
+                    return false;
+                }
+                break;
+        }
+        return true;
+    });
+    if (value == text.size() || text[value] != '[') {
+        return std::nullopt;
+    }
+
+    ArrayLayout layout;
+    layout.open = value;
+    layout.close = text.size();
+    int array_depth = 0;
+    ForEachStructural(text, index, value, [&](size_t pos, char c) {
+        if (c == '[' || c == '{') {
+            ++array_depth;
+        } else if (c == ']' || c == '}') {
+            if (--array_depth == 0) {
+                layout.close = pos;
+                return false;
+            }
+        } else if (c == ',' && array_depth == 1) {
+            layout.commas.push_back(pos);
+        }
+        return true;
+    });
+    if (layout.close == text.size()) {
+        return std::nullopt;
+    }
+    return layout;
+}
+
+}  // namespace
+
+std::optional<ChunkedArray> LoadRootArray(std::string_view text, std::string_view key, size_t chunk_count) {
+    const detail::StructuralIndex index = detail::IndexStructurals(text);
+    if (index.failed) {
+        return std::nullopt;
+    }
+    std::optional<ArrayLayout> layout = FindRootArray(text, index, key);
+    if (!layout) {
+        return std::nullopt;
+    }
+
+    // части примерно равного размера, разрезанные по запятым верхнего уровня
+    const size_t elements_begin = layout->open + 1;
+    const size_t size = layout->close - elements_begin;
+    chunk_count = std::max<size_t>(1, std::min(chunk_count, layout->commas.size() + 1));
+    std::vector<std::string_view> parts;
+    size_t part_begin = elements_begin;
+    auto comma = layout->commas.begin();
+    for (size_t i = 1; i < chunk_count; ++i) {
+        const size_t target = elements_begin + size * i / chunk_count;
+        comma = std::lower_bound(comma, layout->commas.end(), std::max(target, part_begin));
+        if (comma == layout->commas.end()) {
+            break;
+        }
+        parts.push_back(text.substr(part_begin, *comma - part_begin));
+        part_begin = *comma + 1;
+        ++comma;
+    }
+    parts.push_back(text.substr(part_begin, layout->close - part_begin));
+
+    ChunkedArray result;
+    result.text_ = text.substr(layout->open, layout->close + 1 - layout->open);
+    for (size_t i = 0; i < parts.size(); ++i) {
+        result.arenas_.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>());
+    }
+    std::vector<std::future<Document>> tasks;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        tasks.push_back(std::async(std::launch::async, [part = parts[i], arena = result.arenas_[i].get()] {
+            return LoadElements(part, arena);
+        }));
+    }
+    for (auto& task : tasks) {
+        result.chunks_.push_back(task.get());
+    }
+    return result;
+}
+
+}  // namespace json::compact
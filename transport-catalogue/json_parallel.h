@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "json_compact.h"
+
+// Параллельный разбор большого массива, например base_requests. Границы элементов
+// верхнего уровня находятся одним проходом по структурному индексу, затем части
+// массива разбираются на отдельных потоках, каждая в свой компактный документ
+// со своей ареной. Строки документов указывают во входной текст.
+namespace json::compact {
+
+class ChunkedArray {
+public:
+    // участок текста от '[' до ']' включительно
+    std::string_view GetText() const {
+        return text_;
+    }
+    // части по порядку текста; корень каждой - массив её элементов
+    const std::vector<Document>& GetChunks() const {
+        return chunks_;
+    }
+
+private:
+    friend std::optional<ChunkedArray> LoadRootArray(std::string_view text, std::string_view key,
+                                                     size_t chunk_count);
+
+    std::string_view text_;
+    // арены объявлены раньше документов и переживают их
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> arenas_;
+    std::vector<Document> chunks_;
+};
+
+// Массив под ключом key корневого словаря text, разобранный не более чем
+// на chunk_count частей параллельно. nullopt, если корень не словарь, ключа нет,
+// под ним не массив или текст слишком велик для структурного индекса
+std::optional<ChunkedArray> LoadRootArray(std::string_view text, std::string_view key, size_t chunk_count);
+
+}  // namespace json::compact
@@ -1,113 +1,550 @@
 #include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <iterator>
 #include <stdexcept>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include "json_reader.h"
+#include "json_sax.h"
 #include "map_renderer.h"
 
 namespace ctlg::jreader {
 
 using namespace std::literals;
 
-JsonReader::JsonReader(RequestHandler& handler, std::istream& input):
-    handler_(handler), doc_(json::Load(input)){
+namespace {
 
+//Принимает события разбора всего входного JSON text. Каждый запрос из base_requests
+//собирается в компактный документ, разбирается по тем же схемам, что и в ApplyCommands(),
+//и применяется к справочнику, как только закрыт; документ запроса переиспользуется.
+//Остальные разделы собираются в обычный DOM. Расстояния до ещё не встреченных остановок и автобусы, у которых
+//известны не все остановки, ждут в таблицах отложенных запросов. Автобусы
+//добавляются строго в порядке входа, поэтому id остановок и автобусов те же,
+//что при применении из документа.
+class StreamingLoader final : public json::sax::Handler {
+public:
+    StreamingLoader(RequestHandler& handler, std::string_view text):
+        handler_(handler), request_(text, request_doc_){
+    }
+
+    bool HasBaseRequests() const {
+        return has_base_requests_;
+    }
+
+    json::Document GetDocument(){
+        return json::Document{dom_.Build()};
+    }
+
+    void Null() override {
+        if(in_base_){
+            request_.Null();
+            EndRequestValue();
+        } else if(base_key_){
+            //base_requests: null пропускается, как и в ApplyCommands()
+            base_key_ = false;
+        } else {
+            dom_.Null();
+        }
+    }
+    void Bool(bool value) override {
+        if(in_base_){
+            request_.Bool(value);
+            EndRequestValue();
+        } else {
+            ExpectNoBaseKey();
+            dom_.Bool(value);
+        }
+    }
+    void Int(int value) override {
+        if(in_base_){
+            request_.Int(value);
+            EndRequestValue();
+        } else {
+            ExpectNoBaseKey();
+            dom_.Int(value);
+        }
+    }
+    void Double(double value) override {
+        if(in_base_){
+            request_.Double(value);
+            EndRequestValue();
+        } else {
+            ExpectNoBaseKey();
+            dom_.Double(value);
+        }
+    }
+    void String(std::string_view value) override {
+        if(in_base_){
+            request_.String(value);
+            EndRequestValue();
+        } else {
+            ExpectNoBaseKey();
+            dom_.String(value);
+        }
+    }
+    void StartArray() override {
+        if(in_base_){
+            request_.StartArray();
+            ++request_depth_;
+        } else if(base_key_){
+            base_key_ = false;
+            in_base_ = true;
+            has_base_requests_ = true;
+        } else {
+            dom_.StartArray();
+            ++depth_;
+        }
+    }
+    void EndArray() override {
+        if(in_base_ && request_depth_ == 0){
+            in_base_ = false;
+            FinishBaseRequests();
+        } else if(in_base_){
+            request_.EndArray();
+            --request_depth_;
+            EndRequestValue();
+        } else {
+            dom_.EndArray();
+            --depth_;
+        }
+    }
+    void StartDict() override {
+        if(in_base_){
+            request_.StartDict();
+            ++request_depth_;
+        } else {
+            ExpectNoBaseKey();
+            dom_.StartDict();
+            ++depth_;
+        }
+    }
+    void Key(std::string_view key) override {
+        if(in_base_){
+            request_.Key(key);
+        } else if(depth_ == 1 && key == "base_requests"sv){
+            //в dom_ этот ключ не попадает, поэтому повтор отсеивается здесь
+            if(seen_base_key_){
+                throw json::ParsingError("Duplicate key 'base_requests' have been found"s);
+            }
+            seen_base_key_ = base_key_ = true;
+        } else {
+            dom_.Key(key);
+        }
+    }
+    void EndDict() override {
+        if(in_base_){
+            request_.EndDict();
+            --request_depth_;
+            EndRequestValue();
+        } else {
+            dom_.EndDict();
+            --depth_;
+        }
+    }
+
+private:
+    struct PendingBus {
+        string name;
+        std::vector<string> stops;
+        bool is_roundtrip;
+        //id уже найденных остановок маршрута, по порядку
+        std::vector<StopId> route;
+    };
+
+    RequestHandler& handler_;
+    json::sax::DocumentBuilder dom_;
+    //вложенность контейнеров вне base_requests
+    int depth_ = 0;
+    bool base_key_ = false;
+    bool seen_base_key_ = false;
+    bool in_base_ = false;
+    bool has_base_requests_ = false;
+    //текущий элемент base_requests и вложенность открытых в нём контейнеров
+    json::compact::Document request_doc_;
+    json::compact::DocumentBuilder request_;
+    int request_depth_ = 0;
+    //имя неизвестной пока остановки -> (откуда, расстояние)
+    std::unordered_map<string, std::vector<std::pair<string, int>>> pending_distances_;
+    std::deque<PendingBus> pending_buses_;
+
+    void ExpectNoBaseKey() const {
+        if(base_key_){
+            throw std::logic_error("Not an array"s);
+        }
+    }
+
+    //элемент base_requests закрыт, если значение было на его верхнем уровне
+    void EndRequestValue(){
+        if(request_depth_ > 0){
+            return;
+        }
+        request_.Finish();
+        const json::compact::Node command = request_doc_.GetRoot();
+        const RequestType type = json::schema::Decode<TypedRequest>(command).type;
+        if(type == RequestType::STOP){
+            ApplyStop(json::schema::Decode<StopRequest>(command));
+        } else if(type == RequestType::BUS){
+            ApplyBus(json::schema::Decode<BusRequest>(command));
+        }
+        request_.Clear();
+    }
+
+    void ApplyStop(const StopRequest& stop){
+        handler_.AddStop(Stop{stop.name, {stop.latitude, stop.longitude}});
+        for(const auto& [stop_to, dist] : stop.road_distances){
+            if(handler_.GetStop(stop_to)){
+                handler_.SetDistance(stop.name, stop_to, dist);
+            } else {
+                pending_distances_[string{stop_to}].emplace_back(stop.name, dist);
+            }
+        }
+        if(auto it = pending_distances_.find(string{stop.name}); it != pending_distances_.end()){
+            for(const auto& [stop_from, dist] : it->second){
+                handler_.SetDistance(stop_from, stop.name, dist);
+            }
+            pending_distances_.erase(it);
+        }
+        AddReadyBuses();
+    }
+
+    void ApplyBus(const BusRequest& request){
+        PendingBus& bus = pending_buses_.emplace_back();
+        bus.name = string{request.name};
+        bus.stops.assign(request.stops.begin(), request.stops.end());
+        bus.is_roundtrip = request.is_roundtrip;
+        bus.route.reserve(bus.stops.size());
+        AddReadyBuses();
+    }
+
+    //добавляет автобусы из начала очереди, пока все их остановки известны
+    void AddReadyBuses(){
+        while(!pending_buses_.empty()){
+            PendingBus& bus = pending_buses_.front();
+            while(bus.route.size() < bus.stops.size()){
+                StopPtr stop = handler_.GetStop(bus.stops[bus.route.size()]);
+                if(!stop){
+                    return;
+                }
+                bus.route.push_back(stop->id_);
+            }
+            handler_.AddBus(Bus{bus.name, std::move(bus.route), bus.is_roundtrip});
+            pending_buses_.pop_front();
+        }
+    }
+
+    void FinishBaseRequests(){
+        if(!pending_distances_.empty()){
+            throw std::runtime_error("JsonReader: road distance to unknown stop "s
+                                     + pending_distances_.begin()->first);
+        }
+        if(!pending_buses_.empty()){
+            const PendingBus& bus = pending_buses_.front();
+            throw std::runtime_error("JsonReader: bus "s + bus.name + " has unknown stop "s
+                                     + bus.stops[bus.route.size()]);
+        }
+    }
+};
+
+//вызывает f(i) для всех i из [0, count), каждый на своём потоке
+template <typename F>
+void ForEachChunk(size_t count, F f){
+    vector<std::future<void>> tasks;
+    for(size_t i = 0; i < count; ++i){
+        tasks.push_back(std::async(std::launch::async, f, i));
+    }
+    for(auto& task : tasks){
+        task.get();
+    }
 }
 
-json::Node JsonReader::GetUpLevelNode(const string& key_name) const {
-    const json::Node& root = doc_.GetRoot();
-    if(!root.IsDict()){
-        return {};
+struct DistanceIds {
+    StopId from;
+    StopId to;
+    int dist;
+};
+
+//запросы одной части base_requests
+struct ChunkRequests {
+    vector<StopRequest> stops;
+    vector<BusRequest> buses;
+    vector<DistanceIds> distances;
+    //маршруты buses в виде id остановок
+    vector<vector<StopId>> routes;
+};
+
+
+//разбирает все запросы до первого ответа: ошибка в запросе не оставляет
+//в выводе начатый массив
+void CheckStatRequests(const json::Array& reqs, bool read_only){
+    using json::schema::Decode;
+    for(const json::Node& req : reqs){
+        const RequestType type = Decode<TypedRequest>(req).type;
+        if(read_only && IsUpdateRequest(type)){
+            throw std::runtime_error("JsonReader::GetStats: catalogue snapshot is read-only. "s);
+        }
+        switch(type){
+            case RequestType::BUS:
+            case RequestType::STOP:
+            case RequestType::REMOVE_BUS:
+                Decode<NamedRequest>(req);
+                break;
+            case RequestType::MAP:
+                Decode<MapRequest>(req);
+                break;
+            case RequestType::ROUTE:
+                Decode<RouteRequest>(req);
+                break;
+            case RequestType::NEAREST_STOPS:
+                Decode<NearestStopsRequest>(req);
+                break;
+            case RequestType::STOPS_IN_AREA:
+                Decode<StopsInAreaRequest>(req);
+                break;
+            case RequestType::MEMORY_REPORT:
+                Decode<IdRequest>(req);
+                break;
+            case RequestType::ADD_BUS:
+                Decode<AddBusRequest>(req);
+                break;
+            case RequestType::UPDATE_DISTANCE:
+                Decode<UpdateDistanceRequest>(req);
+                break;
+            case RequestType::MOVE_STOP:
+                Decode<MoveStopRequest>(req);
+                break;
+            case RequestType::UNKNOWN:
+                throw std::runtime_error("JsonReader::GetStats: Unknown stat request type. "s);
+        }
     }
-    const json::Dict& requests = root.AsDict();
-    if(requests.count(string{key_name})) {
-        return requests.at(key_name);
+}
+
+} //namespace
+
+JsonReader::JsonReader(RequestHandler& handler, std::istream& input, InputMode mode):
+    handler_(handler), doc_(json::Node{}){
+    if(mode == InputMode::DOCUMENT){
+        input_.emplace(json::compact::Load(input, &input_arena_));
+        doc_ = MakeStatsDocument(*input_);
+        return;
+    }
+    input_text_ = json::ReadAll(input);
+    Load(input_text_, mode);
+    if(mode == InputMode::STREAM){
+        input_text_ = string{};
     }
-    return {};
 }
 
-void JsonReader::ApplyCommands(){
-    json::Node base_requests = GetUpLevelNode("base_requests"s);
-    if(base_requests == json::Node{}){
+JsonReader::JsonReader(RequestHandler& handler, std::string_view input, InputMode mode):
+    handler_(handler), doc_(json::Node{}){
+    Load(input, mode);
+}
+
+void JsonReader::Load(std::string_view input, InputMode mode){
+    if(mode == InputMode::STREAM){
+        doc_ = LoadStreaming(input);
         return;
     }
-    const json::Array& commands = base_requests.AsArray();
-    //add all Stops
-    for(const json::Node& command : commands){
-        const json::Dict& req = command.AsDict();
-        if(IsStopRequest(req)){
-            AddStop(req);
+    if(mode == InputMode::PARALLEL){
+        const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        base_chunks_ = json::compact::LoadRootArray(input, "base_requests"sv, threads);
+        if(base_chunks_){
+            //остальные разделы - тот же текст, где вместо base_requests стоит null
+            const string_view base = base_chunks_->GetText();
+            const size_t offset = static_cast<size_t>(base.data() - input.data());
+            string rest;
+            rest.reserve(input.size() - base.size() + 4);
+            rest.append(input.substr(0, offset)).append("null"sv).append(input.substr(offset + base.size()));
+            doc_ = MakeStatsDocument(json::compact::Load(rest));
+            return;
+        }
+        //без массива base_requests разбор обычный
+    }
+    input_.emplace(json::compact::Load(input, &input_arena_));
+    doc_ = MakeStatsDocument(*input_);
+}
+
+//Разбор запросов и поиск остановок по именам идут по частям параллельно, а добавление
+//в справочник - по порядку: от него зависят id остановок и автобусов
+void JsonReader::ApplyChunks(const json::compact::ChunkedArray& base){
+    const vector<json::compact::Document>& chunks = base.GetChunks();
+    vector<ChunkRequests> parts(chunks.size());
+    ForEachChunk(chunks.size(), [&chunks, &parts](size_t i){
+        for(json::compact::Node command : chunks[i].GetRoot().AsArray()){
+            const RequestType type = json::schema::Decode<TypedRequest>(command).type;
+            if(type == RequestType::STOP){
+                parts[i].stops.push_back(json::schema::Decode<StopRequest>(command));
+            } else if(type == RequestType::BUS){
+                parts[i].buses.push_back(json::schema::Decode<BusRequest>(command));
+            }
+        }
+    });
+    for(const ChunkRequests& part : parts){
+        for(const StopRequest& stop : part.stops){
+            AddStop(stop);
         }
     }
-    // add stops distances
-    for(const json::Node& command : commands){
-        const json::Dict& req = command.AsDict();
-        if(IsStopRequest(req)){
-            AddStopDistances(req);
+    //остановки больше не добавляются, поэтому индекс имён только читается
+    ForEachChunk(parts.size(), [this, &parts](size_t i){
+        auto get_stop = [this](string_view name){
+            StopPtr stop = handler_.GetStop(name);
+            if(!stop){
+                throw std::runtime_error("JsonReader: unknown stop "s + string{name});
+            }
+            return stop->id_;
+        };
+        ChunkRequests& part = parts[i];
+        for(const StopRequest& stop : part.stops){
+            const StopId from = get_stop(stop.name);
+            for(const auto& [stop_to, dist] : stop.road_distances){
+                part.distances.push_back({from, get_stop(stop_to), dist});
+            }
+        }
+        part.routes.reserve(part.buses.size());
+        for(const BusRequest& bus : part.buses){
+            vector<StopId>& route = part.routes.emplace_back();
+            route.reserve(bus.stops.size());
+            for(string_view stop : bus.stops){
+                route.push_back(get_stop(stop));
+            }
+        }
+    });
+    for(const ChunkRequests& part : parts){
+        for(const DistanceIds& distance : part.distances){
+            handler_.SetDistance(distance.from, distance.to, distance.dist);
         }
     }
-    //add buses
-    for(const json::Node& command : commands){
-        const json::Dict& req = command.AsDict();
-        if(IsBusRequest(req)){
-            AddBus(req);
+    for(ChunkRequests& part : parts){
+        for(size_t i = 0; i < part.buses.size(); ++i){
+            handler_.AddBus(Bus{part.buses[i].name, std::move(part.routes[i]), part.buses[i].is_roundtrip});
         }
     }
 }
 
-bool JsonReader::IsStopRequest(const json::Dict& req) const{
-    return req.at("type"s).AsString() ==  "Stop"s;
-}
-bool JsonReader::IsBusRequest(const json::Dict& req) const{
-    return req.at("type"s).AsString() ==  "Bus"s;
+json::Document JsonReader::LoadStreaming(std::string_view input){
+    StreamingLoader loader{handler_, input};
+    json::sax::Parse(input, loader);
+    streamed_ = loader.HasBaseRequests();
+    return loader.GetDocument();
 }
 
-bool JsonReader::IsMapRequest(const json::Dict& req) const {
-    return req.at("type"s).AsString() ==  "Map"s;
+//всё, кроме base_requests, в виде обычного DOM; base_requests читаются из компактного
+json::Document JsonReader::MakeStatsDocument(const json::compact::Document& input){
+    json::compact::Node root = input.GetRoot();
+    if(!root.IsDict()){
+        return json::Document{root.ToNode()};
+    }
+    json::Dict result;
+    for(const auto& [key, value] : root.AsDict()){
+        if(key != "base_requests"sv){
+            result.emplace(string{key}, value.ToNode());
+        }
+    }
+    return json::Document{result};
 }
 
-bool JsonReader::IsRouteRequest(const json::Dict& req) const {
-    return req.at("type"s).AsString() ==  "Route"s;
+const json::Node& JsonReader::GetUpLevelNode(string_view key_name) const {
+    static const json::Node null_node;
+    const json::Node& root = doc_.GetRoot();
+    if(!root.IsDict()){
+        return null_node;
+    }
+    const json::Dict& requests = root.AsDict();
+    auto it = requests.find(key_name);
+    return it != requests.end() ? it->second : null_node;
 }
 
-void JsonReader::AddStop(const json::Dict& stop){
-    Stop new_stop{stop.at("name").AsString(), {stop.at("latitude").AsDouble(), stop.at("longitude").AsDouble()}};
-    handler_.AddStop(new_stop);
+void JsonReader::ApplyCommands(){
+    if(base_chunks_){
+        ApplyChunks(*base_chunks_);
+        base_chunks_.reset();
+        input_text_ = string{};
+        handler_.UpdateBusStats();
+        handler_.FreezeCatalogue();
+        return;
+    }
+    if(!input_){
+        //base_requests применены при потоковом разборе или уже применены раньше
+        if(std::exchange(streamed_, false)){
+            handler_.UpdateBusStats();
+            handler_.FreezeCatalogue();
+        }
+        return;
+    }
+    json::compact::Node root = input_->GetRoot();
+    if(!root.IsDict() || !root.AsDict().count("base_requests"sv) || root.AsDict().at("base_requests"sv).IsNull()){
+        return;
+    }
+    //запросы разбираются один раз; строки в них указывают во входной документ
+    std::vector<StopRequest> stops;
+    std::vector<BusRequest> buses;
+    for(json::compact::Node command : root.AsDict().at("base_requests"sv).AsArray()){
+        const RequestType type = json::schema::Decode<TypedRequest>(command).type;
+        if(type == RequestType::STOP){
+            stops.push_back(json::schema::Decode<StopRequest>(command));
+        } else if(type == RequestType::BUS){
+            buses.push_back(json::schema::Decode<BusRequest>(command));
+        }
+    }
+    for(const StopRequest& stop : stops){
+        AddStop(stop);
+    }
+    for(const StopRequest& stop : stops){
+        AddStopDistances(stop);
+    }
+    for(const BusRequest& bus : buses){
+        AddBus(bus);
+    }
+    //справочник скопировал всё нужное, входной документ больше не нужен
+    input_.reset();
+    input_arena_.release();
+    input_text_ = string{};
+    handler_.UpdateBusStats();
+    handler_.FreezeCatalogue();
 }
 
-void JsonReader::AddStopDistances(const json::Dict& stop){
-    const json::Dict& dists = stop.at("road_distances").AsDict();
-    for(auto& [stop_to, dist] : dists){
-        handler_.SetDistance(stop.at("name").AsString(), stop_to, dist.AsInt());
+bool JsonReader::HasUpdateRequests() const {
+    const json::Node& stat_requests = GetUpLevelNode("stat_requests"sv);
+    if(!stat_requests.IsArray()){
+        return false;
     }
+    for(const json::Node& req : stat_requests.AsArray()){
+        if(IsUpdateRequest(json::schema::Decode<TypedRequest>(req).type)){
+            return true;
+        }
+    }
+    return false;
 }
 
-void JsonReader::AddBus(const json::Dict& bus){
-    std::string bus_name = bus.at("name").AsString();
-    std::vector<std::string> stops_names;
-    const json::Array& stops = bus.at("stops").AsArray();
-    bool is_roundtrip = bus.at("is_roundtrip").AsBool();
-    // Stop* last_stop = nullptr;
-    for(const json::Node& name : stops){
-        stops_names.push_back(name.AsString());
-    }
-    // if(!is_roundtrip && stops_names.size() > 0){
-    //     last_stop = handler_.GetStop(stops_names.back());
-    // }
-    vector<string_view> results(stops_names.begin(), stops_names.end());
-    if(!is_roundtrip){
-        results.insert(results.end(), std::next(stops_names.rbegin()), stops_names.rend());
+void JsonReader::AddStop(const StopRequest& stop){
+    handler_.AddStop(Stop{stop.name, {stop.latitude, stop.longitude}});
+}
+
+void JsonReader::AddStopDistances(const StopRequest& stop){
+    for(const auto& [stop_to, dist] : stop.road_distances){
+        handler_.SetDistance(stop.name, stop_to, dist);
     }
-    std::vector<Stop*> route_stops;
-    for(string_view& stop : results){
-        route_stops.push_back(handler_.GetStop(stop));
+}
+
+void JsonReader::AddBus(const BusRequest& bus) const {
+    std::vector<StopId> route_stops;
+    route_stops.reserve(bus.stops.size());
+    for(string_view name : bus.stops){
+        StopPtr stop = handler_.GetStop(name);
+        if(!stop){
+            throw std::runtime_error("JsonReader: unknown stop "s + string{name});
+        }
+        route_stops.push_back(stop->id_);
     }
-    handler_.AddBus(Bus{std::move(bus_name), std::move(route_stops), is_roundtrip});
+    handler_.AddBus(Bus{bus.name, std::move(route_stops), bus.is_roundtrip});
 }
 
-json::Node JsonReader::GetStopStat(const json::Dict& req) const {
-    int id_node = req.at("id").AsInt();
-    const string& stop_name = req.at("name").AsString();
-    StopPtr stop = handler_.GetStop(stop_name);
+json::Node JsonReader::GetStopStat(const NamedRequest& req, const TransportCatalogue& db) const {
+    int id_node = req.id;
+    StopPtr stop = db.GetStop(req.name);
     if(!stop){
         return json::Builder()
             .StartDict()
@@ -115,9 +552,9 @@ json::Node JsonReader::GetStopStat(const json::Dict& req) const {
                 .Key("error_message"s).Value("not found"s)
             .EndDict().Build();
     } else {
-        StopStat stat = handler_.GetStopStat(*stop);
+        StopStat stat = db.GetStopStat(*stop);
         json::Array buses;
-        for(string_view& bus_name : stat.buses){
+        for(string_view bus_name : stat.buses){
             buses.push_back(string{bus_name});
         }
         return json::Builder().StartDict()
@@ -127,17 +564,16 @@ json::Node JsonReader::GetStopStat(const json::Dict& req) const {
     }
 }
 
-json::Node JsonReader::GetBusStat(const json::Dict& req) const {
-    int id_node = req.at("id").AsInt();
-    const string& bus_name = req.at("name").AsString();
-    BusPtr bus = handler_.GetBus(bus_name);
+json::Node JsonReader::GetBusStat(const NamedRequest& req, const TransportCatalogue& db) const {
+    int id_node = req.id;
+    BusPtr bus = db.GetBus(req.name);
     if(!bus){
         return json::Builder().StartDict()
             .Key("request_id"s).Value(id_node)
             .Key("error_message"s).Value("not found"s)
             .EndDict().Build();
     } else {
-        BusStat stat = handler_.GetBusStat(*bus);
+        BusStat stat = db.GetBusStat(*bus);
         double curvature = static_cast<double>(stat.lenght) / stat.lenght_geo;
         return json::Builder().StartDict()
             .Key("request_id"s).Value(id_node)
@@ -149,29 +585,46 @@ json::Node JsonReader::GetBusStat(const json::Dict& req) const {
     }
 }
 
-json::Node JsonReader::GetMapStat(const json::Dict& req) const {
-    int id = req.at("id").AsInt();
-
+string JsonReader::RenderMap(const std::optional<GeoArea>& viewport) const {
     std::stringstream ss;
     renderer::RenderSettings sett = GetRendererSettings();
     renderer::MapRenderer renderer{sett};
     // auto routes = handler_.GetRoutes();
-    renderer.SetRoutes(handler_.GetRoutes());
+    renderer.SetRoutes(handler_.GetRoutes(), handler_.GetCatalogue().GetAllStops());
     // renderer.SetRoutes(routes);
+    if(viewport){
+        geo::Coordinates min{viewport->min_latitude, viewport->min_longitude};
+        geo::Coordinates max{viewport->max_latitude, viewport->max_longitude};
+        renderer.SetViewport({min, max, handler_.GetStopsInArea(min, max)});
+    }
     svg::Document doc = renderer.RenderMap();
     doc.Render(ss);
+    return ss.str();
+}
+
+json::Node JsonReader::GetMapStat(const IdRequest& req) const {
+    return GetMapStat(req, RenderMap());
+}
+
+json::Node JsonReader::GetMapStat(const IdRequest& req, const string& map) const {
     return json::Builder()
         .StartDict()
-            .Key("request_id"s).Value(id)
-            .Key("map"s).Value(ss.str())
+            .Key("request_id"s).Value(req.id)
+            .Key("map"s).Value(map)
         .EndDict().Build();
 }
 
-json::Node JsonReader::GetRouteStat(const json::Dict& req, const transport_router& tr_router) const {
-    int id = req.at("id").AsInt();
-    const string& stop_from = req.at("from"s).AsString();
-    const string& stop_to = req.at("to"s).AsString();
-    auto route_info = tr_router.CreateRoute(stop_from, stop_to);
+json::Node JsonReader::GetRouteStat(const RouteRequest& req, const transport_router& tr_router) const {
+    int id = req.id;
+    graph::SearchBudget budget = GetRouteBudget(req);
+    auto route_info = tr_router.CreateRoute(req.from, req.to, budget);
+    if(budget.IsExhausted()){
+        return json::Builder()
+            .StartDict()
+                .Key("request_id"s).Value(id)
+                .Key("error_message"s).Value("timeout"s)
+            .EndDict().Build();
+    }
     if(!route_info){
         return json::Builder()
             .StartDict()
@@ -212,101 +665,283 @@ json::Node JsonReader::GetRouteStat(const json::Dict& req, const transport_route
     }
 }
 
-std::string JsonReader::GetStats() const{
-    std::stringstream out;
-    json::Array answers;
-    json::Node stat_requests = GetUpLevelNode("stat_requests"s);
-    if(!stat_requests.IsArray()){
-        return ""s;
+json::Node JsonReader::GetNearestStopsStat(const NearestStopsRequest& req, const TransportCatalogue& db) const {
+    int id = req.id;
+    geo::Coordinates point{req.latitude, req.longitude};
+    json::Array stops;
+    for(auto [stop, dist] : db.GetNearestStops(point, req.count)){
+        stops.push_back(
+            json::Builder()
+                .StartDict()
+                    .Key("name"s).Value(string(stop->name_))
+                    .Key("distance"s).Value(dist)
+                .EndDict().Build()
+            );
     }
-    RoutingSettings route_settings = GetRoutingSettings();
-    transport_router router{handler_.GetCatalogue(), route_settings};
-    router.CreateAllData();
-    const json::Array& reqs = stat_requests.AsArray();
-    for(const json::Node& req : reqs){
-        if(IsBusRequest(req.AsDict())){
-            answers.push_back(GetBusStat(req.AsDict()));
-        } else if(IsStopRequest(req.AsDict())){
-            answers.push_back(GetStopStat(req.AsDict()));
-        } else if(IsMapRequest(req.AsDict())){
-            answers.push_back(GetMapStat(req.AsDict()));
-        } else if(IsRouteRequest(req.AsDict())){
-            answers.push_back(GetRouteStat(req.AsDict(), router));
-        } else {
-            throw std::runtime_error("JsonReader::GetStats: Unknown stat request type. "s);
-        }
+    return json::Builder()
+        .StartDict()
+            .Key("request_id"s).Value(id)
+            .Key("stops"s).Value(stops)
+        .EndDict().Build();
+}
+
+MemoryReport JsonReader::GetMemoryReport(const TransportCatalogue& db, const transport_router* router,
+                                         const string* map) const {
+    MemoryReport report;
+    db.GetMemoryUsage(report);
+    if(router){
+        router->GetMemoryUsage(report);
+    }
+    report.Add("json.document"s, json::GetMemoryUsage(doc_));
+    report.Add("json.input"s, input_ ? input_->GetMemoryUsage() : MemoryUsage{});
+    if(map){
+        report.Add("svg.map"s, UsageOf(*map));
     }
-    json::Document doc{answers};
-    json::Print(doc, out);
-    return out.str();
+    return report;
 }
 
-RenderSettings JsonReader::GetRendererSettings() const{
-    RenderSettings sett;
-    json::Node render_settings = GetUpLevelNode("render_settings"s);
-    if(render_settings == json::Node{}){
-        return {};
+json::Node JsonReader::MemoryReportToJson(const MemoryReport& report) {
+    auto to_kib = [](size_t bytes){
+        return static_cast<int>((bytes + 1023) / 1024);
+    };
+    auto to_json = [&to_kib](const MemoryUsage& usage){
+        return json::Builder()
+            .StartDict()
+                .Key("kib"s).Value(to_kib(usage.bytes))
+                .Key("allocations"s).Value(static_cast<int>(usage.allocations))
+                .Key("mapped_kib"s).Value(to_kib(usage.mapped_bytes))
+            .EndDict().Build();
+    };
+    json::Dict structures;
+    for(const auto& [name, usage] : report.GetItems()){
+        structures.emplace(name, to_json(usage));
     }
-    const json::Dict& sn = render_settings.AsDict();
-    sett.width = sn.at("width"s).AsDouble();
-    sett.height = sn.at("height").AsDouble();
-    sett.padding = sn.at("padding"s).AsDouble();
-    
-    sett.line_width = sn.at("line_width"s).AsDouble();
-    sett.stop_radius = sn.at("stop_radius"s).AsDouble();
-    sett.bus_label_font_size = (uint32_t)sn.at("bus_label_font_size").AsInt();
+    return json::Builder()
+        .StartDict()
+            .Key("total"s).Value(to_json(report.GetTotal()).GetValue())
+            .Key("structures"s).Value(structures)
+        .EndDict().Build();
+}
 
-    const json::Array& boffset = sn.at("bus_label_offset"s).AsArray();
-    sett.bus_label_offset = {boffset[0].AsDouble(), boffset[1].AsDouble()};
+json::Node JsonReader::GetMemoryReportStat(const IdRequest& req, const TransportCatalogue& db,
+                                           const transport_router& router, const string* map) const {
+    json::Dict answer = MemoryReportToJson(GetMemoryReport(db, &router, map)).AsDict();
+    answer.emplace("request_id"s, req.id);
+    return answer;
+}
 
-    sett.stop_label_font_size = (uint32_t)sn.at("stop_label_font_size"s).AsInt();
-    const json::Array& soffset = sn.at("stop_label_offset"s).AsArray();
-    sett.stop_label_offset = {soffset[0].AsDouble(), soffset[1].AsDouble()};
+json::Node JsonReader::GetStopsInAreaStat(const StopsInAreaRequest& req, const TransportCatalogue& db) const {
+    int id = req.id;
+    geo::Coordinates min{req.min_latitude, req.min_longitude};
+    geo::Coordinates max{req.max_latitude, req.max_longitude};
+    vector<string_view> names;
+    for(const Stop* stop : db.GetStopsInArea(min, max)){
+        names.push_back(stop->name_);
+    }
+    std::sort(names.begin(), names.end());
+    json::Array stops;
+    for(string_view name : names){
+        stops.push_back(string{name});
+    }
+    return json::Builder()
+        .StartDict()
+            .Key("request_id"s).Value(id)
+            .Key("stops"s).Value(stops)
+        .EndDict().Build();
+}
 
-    sett.underlayer_color = ConvertcolorToString(sn.at("underlayer_color"));
-    sett.underlayer_width = sn.at("underlayer_width").AsDouble();
+// Изменяет справочник на месте; производные данные обновляет вызывающий по TakeChanges()
+json::Node JsonReader::ApplyUpdate(const json::Node& req, RequestType type) const {
+    int id = json::schema::Decode<IdRequest>(req).id;
+    bool found = true;
+    if(type == RequestType::ADD_BUS){
+        const AddBusRequest bus = json::schema::Decode<AddBusRequest>(req);
+        if(handler_.GetBus(bus.name)){
+            return json::Builder()
+                .StartDict()
+                    .Key("request_id"s).Value(id)
+                    .Key("error_message"s).Value("already exists"s)
+                .EndDict().Build();
+        }
+        for(string_view stop : bus.stops){
+            found = found && handler_.GetStop(stop);
+        }
+        if(found){
+            AddBus(bus);
+        }
+    } else if(type == RequestType::REMOVE_BUS){
+        found = handler_.RemoveBus(json::schema::Decode<NamedRequest>(req).name);
+    } else if(type == RequestType::UPDATE_DISTANCE){
+        const auto update = json::schema::Decode<UpdateDistanceRequest>(req);
+        found = handler_.GetStop(update.from) && handler_.GetStop(update.to);
+        if(found){
+            handler_.SetDistance(update.from, update.to, update.distance);
+        }
+    } else if(type == RequestType::MOVE_STOP){
+        const auto move = json::schema::Decode<MoveStopRequest>(req);
+        found = handler_.GetStop(move.name);
+        if(found){
+            handler_.MoveStop(move.name, {move.latitude, move.longitude});
+        }
+    }
+    if(!found){
+        return json::Builder()
+            .StartDict()
+                .Key("request_id"s).Value(id)
+                .Key("error_message"s).Value("not found"s)
+            .EndDict().Build();
+    }
+    handler_.UpdateBusStats();
+    return json::Builder()
+        .StartDict()
+            .Key("request_id"s).Value(id)
+        .EndDict().Build();
+}
 
-    sett.color_palette.clear();
-    const json::Array& sp = sn.at("color_palette"s).AsArray();
-    for( const json::Node& nc : sp){
-        sett.color_palette.push_back(ConvertcolorToString(nc));
+// Необязательные поля запроса Route: time_limit (мс) и max_vertices
+graph::SearchBudget JsonReader::GetRouteBudget(const RouteRequest& req) const {
+    graph::SearchBudget budget;
+    if(req.time_limit){
+        std::chrono::duration<double, std::milli> limit{*req.time_limit};
+        budget.SetTimeLimit(std::chrono::duration_cast<graph::SearchBudget::Clock::duration>(limit));
+    }
+    if(req.max_vertices){
+        budget.SetMaxVertices(*req.max_vertices);
     }
+    return budget;
+}
 
-    return sett;
+std::string JsonReader::GetStats(json::PrintStyle style) const{
+    json::Writer writer{style};
+    WriteStats(writer);
+    return writer.TakeBuffer();
 }
 
-RoutingSettings JsonReader::GetRoutingSettings() const{
-    RoutingSettings settings{1001, 1001.0};
-    json::Node routing_settings = GetUpLevelNode("routing_settings"s);
-    if(routing_settings == json::Node{}){
-        return settings;
-    }
-    const json::Dict& rs = routing_settings.AsDict();
-    settings.bus_wait_time = (unsigned int)rs.at("bus_wait_time"s).AsInt();
-    settings.bus_velocity = rs.at("bus_velocity"s).AsDouble();
+std::string JsonReader::GetStats(const CatalogueSnapshot& snapshot, json::PrintStyle style) const{
+    json::Writer writer{style};
+    WriteStats(nullptr, &snapshot, writer);
+    return writer.TakeBuffer();
+}
 
-    return settings;
+void JsonReader::WriteStats(std::ostream& out, json::PrintStyle style) const{
+    json::Writer writer{out, style};
+    WriteStats(writer);
 }
 
-string JsonReader::ConvertcolorToString(json::Node jColor) const{
-    if(jColor.IsString()){
-        return jColor.AsString();
+void JsonReader::WriteStats(const CatalogueSnapshot& snapshot, std::ostream& out, json::PrintStyle style) const{
+    json::Writer writer{out, style};
+    WriteStats(nullptr, &snapshot, writer);
+}
+
+void JsonReader::WriteStats(json::Writer& writer) const{
+    RoutingSettings route_settings = GetRoutingSettings();
+    transport_router router{handler_.GetCatalogue(), route_settings};
+    handler_.TakeChanges();
+    WriteStats(&router, nullptr, writer);
+}
+
+// Без снимка запросы на изменение применяются к справочнику по ходу пакета. Граф и таблица
+// маршрутов router строятся только перед запросом, которому они нужны, и только если с прошлой
+// постройки менялись маршруты; карта так же перерисовывается лишь после изменений, которые её касаются.
+// Каждый ответ сериализуется и отдаётся в поток writer сразу, как готов
+void JsonReader::WriteStats(transport_router* router, const CatalogueSnapshot* snapshot, json::Writer& writer) const{
+    const json::Node& stat_requests = GetUpLevelNode("stat_requests"sv);
+    if(!stat_requests.IsArray()){
+        return;
     }
-    std::stringstream ss;
-    const json::Array& arr = jColor.AsArray();
-    if(arr.size() == 3){
-        ss << "rgb("s 
-            << arr[0].AsInt() << ','
-            << arr[1].AsInt() << ','
-            << arr[2].AsInt() << ')'; 
-    } else if(arr.size() == 4){
-        ss << "rgba("s 
-            << arr[0].AsInt() << ','
-            << arr[1].AsInt() << ','
-            << arr[2].AsInt() << ',' 
-            << arr[3].AsDouble() << ')';
+    const TransportCatalogue& db = snapshot ? snapshot->GetCatalogue() : handler_.GetCatalogue();
+    const transport_router& current_router = snapshot ? snapshot->GetRouter() : *router;
+    std::optional<string> map;
+    //router без снимка создан пустым
+    bool router_stale = !snapshot;
+    auto fresh_router = [&]() -> const transport_router& {
+        if(router_stale){
+            router->CreateAllData();
+            router_stale = false;
+        }
+        return current_router;
+    };
+    const json::Array& reqs = stat_requests.AsArray();
+    CheckStatRequests(reqs, snapshot != nullptr);
+    writer.StartArray();
+    try{
+        for(const json::Node& req : reqs){
+            using json::schema::Decode;
+            const RequestType type = Decode<TypedRequest>(req).type;
+            switch(type){
+                case RequestType::ADD_BUS:
+                case RequestType::REMOVE_BUS:
+                case RequestType::UPDATE_DISTANCE:
+                case RequestType::MOVE_STOP: {
+                    writer.Write(ApplyUpdate(req, type));
+                    CatalogueChanges changes = handler_.TakeChanges();
+                    router_stale = router_stale || changes.routes;
+                    if(changes.map){
+                        map.reset();
+                    }
+                    break;
+                }
+                case RequestType::BUS:
+                    writer.Write(GetBusStat(Decode<NamedRequest>(req), db));
+                    break;
+                case RequestType::STOP:
+                    writer.Write(GetStopStat(Decode<NamedRequest>(req), db));
+                    break;
+                case RequestType::MAP: {
+                    const auto map_req = Decode<MapRequest>(req);
+                    if(map_req.viewport){
+                        const GeoArea& area = *map_req.viewport;
+                        writer.Write(GetMapStat({map_req.id}, snapshot
+                            ? snapshot->RenderMap({area.min_latitude, area.min_longitude},
+                                                  {area.max_latitude, area.max_longitude})
+                            : RenderMap(area)));
+                        break;
+                    }
+                    if(!snapshot && !map){
+                        map = RenderMap();
+                    }
+                    writer.Write(GetMapStat({map_req.id}, snapshot ? snapshot->GetMap() : *map));
+                    break;
+                }
+                case RequestType::ROUTE:
+                    writer.Write(GetRouteStat(Decode<RouteRequest>(req), fresh_router()));
+                    break;
+                case RequestType::NEAREST_STOPS:
+                    writer.Write(GetNearestStopsStat(Decode<NearestStopsRequest>(req), db));
+                    break;
+                case RequestType::STOPS_IN_AREA:
+                    writer.Write(GetStopsInAreaStat(Decode<StopsInAreaRequest>(req), db));
+                    break;
+                case RequestType::MEMORY_REPORT:
+                    writer.Write(GetMemoryReportStat(Decode<IdRequest>(req), db, fresh_router(),
+                                                     snapshot ? snapshot->GetRenderedMap() : map ? &*map : nullptr));
+                    break;
+                case RequestType::UNKNOWN:
+                    throw std::runtime_error("JsonReader::GetStats: Unknown stat request type. "s);
+            }
+        }
+    } catch(...){
+        //выведенная часть ответов остаётся корректным JSON
+        writer.EndArray();
+        throw;
     }
-    return ss.str();
+    writer.EndArray();
+}
+
+RenderSettings JsonReader::GetRendererSettings() const{
+    const json::Node& render_settings = GetUpLevelNode("render_settings"sv);
+    if(render_settings.IsNull()){
+        return {};
+    }
+    return json::schema::Decode<RenderSettings>(render_settings);
+}
+
+RoutingSettings JsonReader::GetRoutingSettings() const{
+    const json::Node& routing_settings = GetUpLevelNode("routing_settings"sv);
+    if(routing_settings.IsNull()){
+        return RoutingSettings{1001, 1001.0};
+    }
+    return json::schema::Decode<RoutingSettings>(routing_settings);
 }
 
 }   //ctlg::jreader
\ No newline at end of file
@@ -1,45 +1,101 @@
 #pragma once
 
 #include <iostream>
+#include <memory_resource>
+#include <optional>
 
 #include "domain.h"
 #include "svg.h"
 #include "json.h"
 #include "json_builder.h"
+#include "json_compact.h"
+#include "json_parallel.h"
+#include "json_requests.h"
+#include "json_writer.h"
 #include "transport_catalogue.h"
 #include "request_handler.h"
 #include "transport_router.h"
 #include "router.h"
+#include "catalogue_snapshot.h"
+#include "memory_usage.h"
 
 namespace ctlg::jreader {
 
     using json::Document, renderer::RenderSettings;
 
+    //Как применяются base_requests:
+    //  DOCUMENT - вход разбирается в компактный DOM, запросы применяются в ApplyCommands();
+    //  STREAM - запросы применяются к справочнику прямо во время разбора, DOM для них не строится;
+    //  PARALLEL - массив base_requests разбирается по частям на нескольких потоках,
+    //             и в ApplyCommands() части обрабатываются параллельно, где позволяет порядок
+    enum class InputMode { DOCUMENT, STREAM, PARALLEL };
+
     class JsonReader{
     public:
-        JsonReader(RequestHandler& handler, std::istream& input);
+        JsonReader(RequestHandler& handler, std::istream& input, InputMode mode = InputMode::DOCUMENT);
+        //разбирает JSON прямо из буфера, например из отображённого в память файла
+        JsonReader(RequestHandler& handler, std::string_view input, InputMode mode = InputMode::DOCUMENT);
         void ApplyCommands();
         json::Array GetStatsRequests() const;
-        bool IsStopRequest(const json::Dict& req) const;
-        bool IsBusRequest(const json::Dict& req) const;
-        bool IsMapRequest(const json::Dict& req) const;
-        bool IsRouteRequest(const json::Dict& req) const;
-        json::Node GetStopStat(const json::Dict& req) const;
-        json::Node GetBusStat(const json::Dict& req) const;
-        json::Node GetMapStat(const json::Dict& req) const;
-        json::Node GetRouteStat(const json::Dict& req, const transport_router& tr_router) const;
-        std::string GetStats() const;
+        //есть ли среди stat_requests AddBus, RemoveBus, UpdateDistance или MoveStop
+        bool HasUpdateRequests() const;
+        //запросы на чтение отвечаются по справочнику db: либо загруженному, либо из снимка
+        json::Node GetStopStat(const NamedRequest& req, const TransportCatalogue& db) const;
+        json::Node GetBusStat(const NamedRequest& req, const TransportCatalogue& db) const;
+        json::Node GetMapStat(const IdRequest& req) const;
+        json::Node GetMapStat(const IdRequest& req, const string& map) const;
+        json::Node GetRouteStat(const RouteRequest& req, const transport_router& tr_router) const;
+        json::Node GetNearestStopsStat(const NearestStopsRequest& req, const TransportCatalogue& db) const;
+        json::Node GetStopsInAreaStat(const StopsInAreaRequest& req, const TransportCatalogue& db) const;
+        json::Node GetMemoryReportStat(const IdRequest& req, const TransportCatalogue& db,
+                                       const transport_router& router, const string* map) const;
+        //справочник db, граф и таблица маршрутов router, DOM входного JSON и уже отрисованная
+        //карта map; router и map могут быть nullptr
+        MemoryReport GetMemoryReport(const TransportCatalogue& db, const transport_router* router,
+                                     const string* map = nullptr) const;
+        //{"total": {...}, "structures": {имя: {...}}}, размеры в КиБ с округлением вверх
+        static json::Node MemoryReportToJson(const MemoryReport& report);
+        //ответы на stat_requests в виде JSON-массива
+        std::string GetStats(json::PrintStyle style = json::PrintStyle::PRETTY) const;
+        //ответы на маршруты и карту берутся из готового снимка справочника
+        std::string GetStats(const CatalogueSnapshot& snapshot, json::PrintStyle style = json::PrintStyle::PRETTY) const;
+        //то же, что GetStats, но каждый ответ пишется в out, как только готов,
+        //поэтому в памяти держится один ответ, а не весь массив
+        void WriteStats(std::ostream& out, json::PrintStyle style = json::PrintStyle::PRETTY) const;
+        void WriteStats(const CatalogueSnapshot& snapshot, std::ostream& out,
+                        json::PrintStyle style = json::PrintStyle::PRETTY) const;
         RenderSettings GetRendererSettings() const;
         RoutingSettings GetRoutingSettings() const;
     private:
         RequestHandler& handler_;
+        //входной документ в компактном виде целиком лежит в арене и
+        //освобождается одним release() после ApplyCommands()
+        std::pmr::monotonic_buffer_resource input_arena_;
+        std::optional<json::compact::Document> input_;
+        //прочитанный из потока текст, пока на него указывают input_ или base_chunks_
+        string input_text_;
+        //base_requests, разобранные по частям в режиме PARALLEL
+        std::optional<json::compact::ChunkedArray> base_chunks_;
+        //base_requests уже применены потоковым разбором
+        bool streamed_ = false;
         json::Document doc_;
 
         
-        json::Node GetUpLevelNode(const string& key_name) const;
-        void AddStop(const json::Dict& stop);
-        void AddStopDistances(const json::Dict& stop);
-        void AddBus(const json::Dict& bus);
-        string ConvertcolorToString(json::Node jColor) const;
+        //раздел верхнего уровня или null, без копирования
+        const json::Node& GetUpLevelNode(string_view key_name) const;
+        void WriteStats(json::Writer& writer) const;
+        void WriteStats(transport_router* router, const CatalogueSnapshot* snapshot, json::Writer& writer) const;
+        json::Node ApplyUpdate(const json::Node& req, RequestType type) const;
+        //с viewport - карта только этой области
+        string RenderMap(const std::optional<GeoArea>& viewport = std::nullopt) const;
+        static json::Document MakeStatsDocument(const json::compact::Document& input);
+        void Load(std::string_view input, InputMode mode);
+        //применяет base_requests по ходу разбора и возвращает остальные разделы
+        json::Document LoadStreaming(std::string_view input);
+        void ApplyChunks(const json::compact::ChunkedArray& base);
+        void AddStop(const StopRequest& stop);
+        void AddStopDistances(const StopRequest& stop);
+        void AddBus(const BusRequest& bus) const;
+        graph::SearchBudget GetRouteBudget(const RouteRequest& req) const;
     };
 } //ctlg::jreader
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include <array>
+#include <sstream>
+
+#include "json_requests.h"
+
+namespace ctlg::jreader {
+
+using namespace std::literals;
+
+RequestType ToRequestType(std::string_view type) {
+    static const std::array<std::pair<std::string_view, RequestType>, 11> types{{
+        {"Stop"sv, RequestType::STOP},
+        {"Bus"sv, RequestType::BUS},
+        {"Map"sv, RequestType::MAP},
+        {"Route"sv, RequestType::ROUTE},
+        {"NearestStops"sv, RequestType::NEAREST_STOPS},
+        {"StopsInArea"sv, RequestType::STOPS_IN_AREA},
+        {"MemoryReport"sv, RequestType::MEMORY_REPORT},
+        {"AddBus"sv, RequestType::ADD_BUS},
+        {"RemoveBus"sv, RequestType::REMOVE_BUS},
+        {"UpdateDistance"sv, RequestType::UPDATE_DISTANCE},
+        {"MoveStop"sv, RequestType::MOVE_STOP},
+    }};
+    for (const auto& [name, value] : types) {
+        if (name == type) {
+            return value;
+        }
+    }
+    return RequestType::UNKNOWN;
+}
+
+bool IsUpdateRequest(RequestType type) {
+    return type == RequestType::ADD_BUS || type == RequestType::REMOVE_BUS
+        || type == RequestType::UPDATE_DISTANCE || type == RequestType::MOVE_STOP;
+}
+
+svg::Color ColorDecoder::Decode(const json::Node& node) {
+    if (node.IsString()) {
+        return node.AsString();
+    }
+    std::stringstream ss;
+    const json::Array& arr = node.AsArray();
+    if (arr.size() == 3) {
+        ss << "rgb("s
+            << arr[0].AsInt() << ','
+            << arr[1].AsInt() << ','
+            << arr[2].AsInt() << ')';
+    } else if (arr.size() == 4) {
+        ss << "rgba("s
+            << arr[0].AsInt() << ','
+            << arr[1].AsInt() << ','
+            << arr[2].AsInt() << ','
+            << arr[3].AsDouble() << ')';
+    }
+    return ss.str();
+}
+
+}  // namespace ctlg::jreader
@@ -0,0 +1,326 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "domain.h"
+#include "json.h"
+#include "json_schema.h"
+#include "map_renderer.h"
+#include "svg.h"
+
+// Запросы входного JSON в виде структур. Строки - виды на документ, из которого
+// запрос разобран, поэтому структура не должна его переживать.
+namespace ctlg::jreader {
+
+// Тип запроса по полю "type"; Stop и Bus означают и добавление в base_requests,
+// и статистику в stat_requests
+enum class RequestType {
+    STOP,
+    BUS,
+    MAP,
+    ROUTE,
+    NEAREST_STOPS,
+    STOPS_IN_AREA,
+    MEMORY_REPORT,
+    ADD_BUS,
+    REMOVE_BUS,
+    UPDATE_DISTANCE,
+    MOVE_STOP,
+    UNKNOWN
+};
+
+RequestType ToRequestType(std::string_view type);
+//AddBus, RemoveBus, UpdateDistance, MoveStop среди stat_requests
+bool IsUpdateRequest(RequestType type);
+
+//только поле "type", чтобы выбрать, в какую структуру разбирать запрос
+struct TypedRequest {
+    RequestType type;
+};
+
+//Stop в base_requests
+struct StopRequest {
+    std::string_view name;
+    double latitude;
+    double longitude;
+    std::vector<std::pair<std::string_view, int>> road_distances;
+};
+
+//Bus в base_requests
+struct BusRequest {
+    std::string_view name;
+    std::vector<std::string_view> stops;
+    bool is_roundtrip;
+};
+
+//Map и MemoryReport
+struct IdRequest {
+    int id;
+};
+
+//прямоугольник в градусах
+struct GeoArea {
+    double min_latitude;
+    double min_longitude;
+    double max_latitude;
+    double max_longitude;
+};
+
+//с viewport карта отрисовывается только для этой области
+struct MapRequest {
+    int id;
+    std::optional<GeoArea> viewport;
+};
+
+//Stop и Bus в stat_requests, RemoveBus
+struct NamedRequest {
+    int id;
+    std::string_view name;
+};
+
+//time_limit в миллисекундах и max_vertices ограничивают поиск
+struct RouteRequest {
+    int id;
+    std::string_view from;
+    std::string_view to;
+    std::optional<double> time_limit;
+    std::optional<size_t> max_vertices;
+};
+
+struct NearestStopsRequest {
+    int id;
+    double latitude;
+    double longitude;
+    size_t count;
+};
+
+struct StopsInAreaRequest {
+    int id;
+    double min_latitude;
+    double min_longitude;
+    double max_latitude;
+    double max_longitude;
+};
+
+struct AddBusRequest : BusRequest {
+    int id;
+};
+
+struct UpdateDistanceRequest {
+    int id;
+    std::string_view from;
+    std::string_view to;
+    int distance;
+};
+
+struct MoveStopRequest {
+    int id;
+    std::string_view name;
+    double latitude;
+    double longitude;
+};
+
+//строка или массив [r, g, b] / [r, g, b, opacity]
+struct ColorDecoder {
+    static svg::Color Decode(const json::Node& node);
+};
+
+}  // namespace ctlg::jreader
+
+namespace json::schema {
+
+template <>
+struct Decoder<ctlg::jreader::RequestType> {
+    template <typename NodeT>
+    static ctlg::jreader::RequestType Decode(const NodeT& node) {
+        return ctlg::jreader::ToRequestType(node.AsString());
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::TypedRequest> {
+    using T = ctlg::jreader::TypedRequest;
+    static auto Fields() {
+        return std::make_tuple(MakeField("type", &T::type));
+    }
+};
+
+template <>
+struct Decoder<svg::Point> {
+    template <typename NodeT>
+    static svg::Point Decode(const NodeT& node) {
+        const auto& offset = node.AsArray();
+        return {offset[0].AsDouble(), offset[1].AsDouble()};
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::StopRequest> {
+    using T = ctlg::jreader::StopRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("name", &T::name),
+            MakeField("latitude", &T::latitude),
+            MakeField("longitude", &T::longitude),
+            MakeField("road_distances", &T::road_distances));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::BusRequest> {
+    using T = ctlg::jreader::BusRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("name", &T::name),
+            MakeField("stops", &T::stops),
+            MakeField("is_roundtrip", &T::is_roundtrip));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::IdRequest> {
+    using T = ctlg::jreader::IdRequest;
+    static auto Fields() {
+        return std::make_tuple(MakeField("id", &T::id));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::GeoArea> {
+    using T = ctlg::jreader::GeoArea;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("min_latitude", &T::min_latitude),
+            MakeField("min_longitude", &T::min_longitude),
+            MakeField("max_latitude", &T::max_latitude),
+            MakeField("max_longitude", &T::max_longitude));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::MapRequest> {
+    using T = ctlg::jreader::MapRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("id", &T::id),
+            MakeField("viewport", &T::viewport));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::NamedRequest> {
+    using T = ctlg::jreader::NamedRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("id", &T::id),
+            MakeField("name", &T::name));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::RouteRequest> {
+    using T = ctlg::jreader::RouteRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("id", &T::id),
+            MakeField("from", &T::from),
+            MakeField("to", &T::to),
+            MakeField("time_limit", &T::time_limit),
+            MakeField("max_vertices", &T::max_vertices));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::NearestStopsRequest> {
+    using T = ctlg::jreader::NearestStopsRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("id", &T::id),
+            MakeField("latitude", &T::latitude),
+            MakeField("longitude", &T::longitude),
+            MakeField("count", &T::count));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::StopsInAreaRequest> {
+    using T = ctlg::jreader::StopsInAreaRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("id", &T::id),
+            MakeField("min_latitude", &T::min_latitude),
+            MakeField("min_longitude", &T::min_longitude),
+            MakeField("max_latitude", &T::max_latitude),
+            MakeField("max_longitude", &T::max_longitude));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::AddBusRequest> {
+    using T = ctlg::jreader::AddBusRequest;
+    static auto Fields() {
+        return std::tuple_cat(
+            std::make_tuple(MakeField("id", &T::id)),
+            Schema<ctlg::jreader::BusRequest>::Fields());
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::UpdateDistanceRequest> {
+    using T = ctlg::jreader::UpdateDistanceRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("id", &T::id),
+            MakeField("from", &T::from),
+            MakeField("to", &T::to),
+            MakeField("distance", &T::distance));
+    }
+};
+
+template <>
+struct Schema<ctlg::jreader::MoveStopRequest> {
+    using T = ctlg::jreader::MoveStopRequest;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("id", &T::id),
+            MakeField("name", &T::name),
+            MakeField("latitude", &T::latitude),
+            MakeField("longitude", &T::longitude));
+    }
+};
+
+template <>
+struct Schema<RoutingSettings> {
+    using T = RoutingSettings;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("bus_wait_time", &T::bus_wait_time),
+            MakeField("bus_velocity", &T::bus_velocity));
+    }
+};
+
+template <>
+struct Schema<renderer::RenderSettings> {
+    using T = renderer::RenderSettings;
+    using ColorDecoder = ctlg::jreader::ColorDecoder;
+    static auto Fields() {
+        return std::make_tuple(
+            MakeField("width", &T::width),
+            MakeField("height", &T::height),
+            MakeField("padding", &T::padding),
+            MakeField("line_width", &T::line_width),
+            MakeField("stop_radius", &T::stop_radius),
+            MakeField("bus_label_font_size", &T::bus_label_font_size),
+            MakeField("bus_label_offset", &T::bus_label_offset),
+            MakeField("stop_label_font_size", &T::stop_label_font_size),
+            MakeField("stop_label_offset", &T::stop_label_offset),
+            MakeField<ColorDecoder>("underlayer_color", &T::underlayer_color),
+            MakeField("underlayer_width", &T::underlayer_width),
+            MakeField<ArrayOf<ColorDecoder>>("color_palette", &T::color_palette));
+    }
+};
+
+}  // namespace json::schema
@@ -0,0 +1,44 @@
+#include "json_sax.h"
+
+#include <utility>
+#include <variant>
+
+namespace json::sax {
+
+using namespace std::literals;
+
+DocumentBuilder::DocumentBuilder()
+    : slot_(&root_) {
+}
+
+void DocumentBuilder::Key(std::string_view key) {
+    Dict& dict = std::get<Dict>(open_.back()->GetValue());
+    auto [it, inserted] = dict.try_emplace(std::string(key));
+    if (!inserted) {
+        throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+    }
+    slot_ = &it->second;
+}
+
+Node DocumentBuilder::Build() {
+    Node result = std::move(root_);
+    root_ = Node{};
+    open_.clear();
+    slot_ = &root_;
+    return result;
+}
+
+// Значение встаёт на место после ключа или корня, иначе дописывается в открытый массив.
+// Указатели на открытые контейнеры не портятся: массив растёт только когда
+// его вложенный контейнер уже закрыт
+Node& DocumentBuilder::Add(Node::Value value) {
+    if (slot_) {
+        Node& node = *slot_;
+        node.GetValue() = std::move(value);
+        slot_ = nullptr;
+        return node;
+    }
+    return std::get<Array>(open_.back()->GetValue()).emplace_back(std::move(value));
+}
+
+}  // namespace json::sax
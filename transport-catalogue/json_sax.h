@@ -0,0 +1,221 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.h"
+#include "json_scan.h"
+
+// Потоковый (SAX) разбор JSON: дерево не строится, обработчик получает события
+// в порядке текста. Это единственная реализация грамматики: json::Load и
+// json::compact::Load строят свои DOM обработчиками этих событий.
+// Повторяющиеся ключи словаря разбор не отсеивает - это дело обработчика.
+namespace json::sax {
+
+// Строки и ключи указывают во входной буфер или во временный буфер раскодированной
+// строки, поэтому действительны только во время вызова.
+// Parse принимает и любой другой класс с теми же методами, тогда вызовы не виртуальные
+class Handler {
+public:
+    // верхняя оценка числа значений в тексте, приходит до первого значения
+    virtual void Reserve(size_t /*value_count*/) {}
+    virtual void Null() = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Int(int value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void String(std::string_view value) = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void StartDict() = 0;
+    virtual void Key(std::string_view key) = 0;
+    virtual void EndDict() = 0;
+
+    virtual ~Handler() = default;
+};
+
+// Собирает события в дерево json::Node; повторный ключ словаря - ParsingError
+class DocumentBuilder final : public Handler {
+public:
+    DocumentBuilder();
+
+    void Null() override { Add(nullptr); }
+    void Bool(bool value) override { Add(value); }
+    void Int(int value) override { Add(value); }
+    void Double(double value) override { Add(value); }
+    void String(std::string_view value) override { Add(std::string(value)); }
+    void StartArray() override { open_.push_back(&Add(Array{})); }
+    void EndArray() override { open_.pop_back(); }
+    void StartDict() override { open_.push_back(&Add(Dict{})); }
+    void Key(std::string_view key) override;
+    void EndDict() override { open_.pop_back(); }
+
+    // собранное значение; после этого можно собирать следующее
+    Node Build();
+
+private:
+    Node root_;
+    //открытые массивы и словари
+    std::vector<Node*> open_;
+    //место под значение после Key() или под корень
+    Node* slot_;
+
+    Node& Add(Node::Value value);
+};
+
+namespace detail {
+
+template <typename H>
+class Parser : private json::detail::Scanner<ParsingError> {
+public:
+    Parser(std::string_view text, H& handler)
+        : Scanner(text)
+        , handler_(handler) {
+        handler_.Reserve(EstimateValueCount());
+    }
+
+    void ParseNode() {
+        using namespace std::literals;
+        char c;
+        if (!ReadChar(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (c) {
+            case '[':
+                ParseArray();
+                break;
+            case '{':
+                ParseDict();
+                break;
+            case '"':
+                handler_.String(ScanString(decoded_));
+                break;
+            case 't':
+                // Встретив t или f, переходим к попытке парсинга литералов true либо false
+                [[fallthrough]];
+            case 'f':
+                --pos_;
+                ParseBool();
+                break;
+            case 'n':
+                --pos_;
+                ParseNull();
+                break;
+            default:
+                --pos_;
+                ParseNumber();
+        }
+    }
+
+    // Элементы массива, записанные через запятую без скобок, как один массив
+    void ParseElements() {
+        handler_.StartArray();
+        char c;
+        while (ReadChar(c)) {
+            if (c != ',') {
+                --pos_;
+            }
+            ParseNode();
+        }
+        handler_.EndArray();
+    }
+
+private:
+    H& handler_;
+    std::string decoded_;
+
+    void ParseArray() {
+        using namespace std::literals;
+        handler_.StartArray();
+        char c;
+        bool closed = false;
+        while (ReadChar(c)) {
+            if (c == ']') {
+                closed = true;
+                break;
+            }
+            if (c != ',') {
+                --pos_;
+            }
+            ParseNode();
+        }
+        if (!closed) {
+            throw ParsingError("Array parsing error"s);
+        }
+        handler_.EndArray();
+    }
+
+    void ParseDict() {
+        using namespace std::literals;
+        handler_.StartDict();
+        char c;
+        bool closed = false;
+        while (ReadChar(c)) {
+            if (c == '}') {
+                closed = true;
+                break;
+            }
+            if (c == '"') {
+                handler_.Key(ScanString(decoded_));
+                if (ReadChar(c) && c == ':') {
+                    ParseNode();
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        if (!closed) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        handler_.EndDict();
+    }
+
+    void ParseBool() {
+        using namespace std::literals;
+        const auto s = LoadLiteral();
+        if (s == "true"sv) {
+            handler_.Bool(true);
+        } else if (s == "false"sv) {
+            handler_.Bool(false);
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
+        }
+    }
+
+    void ParseNull() {
+        using namespace std::literals;
+        if (auto literal = LoadLiteral(); literal != "null"sv) {
+            throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+        }
+        handler_.Null();
+    }
+
+    void ParseNumber() {
+        const Number number = ScanNumber();
+        if (number.is_int) {
+            handler_.Int(number.int_value);
+        } else {
+            handler_.Double(number.double_value);
+        }
+    }
+};
+
+}  // namespace detail
+
+// Разбирает первое JSON-значение из text, передавая события handler.
+// Исключения обработчика проходят наружу без изменений
+template <typename H>
+void Parse(std::string_view text, H& handler) {
+    detail::Parser<H>{text, handler}.ParseNode();
+}
+
+// Разбирает элементы массива без скобок, например часть большого массива,
+// как один массив: StartArray(), элементы, EndArray()
+template <typename H>
+void ParseElements(std::string_view elements, H& handler) {
+    detail::Parser<H>{elements, handler}.ParseElements();
+}
+
+}  // namespace json::sax
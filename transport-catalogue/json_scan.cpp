@@ -0,0 +1,164 @@
+#include "json_scan.h"
+
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JSON_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace json::detail {
+
+namespace {
+
+bool IsStructural(char c) {
+    switch (c) {
+        case '{': case '}': case '[': case ']': case ':': case ',': case '"': case '\\':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+// Скалярная обработка хвоста [pos, end), не кратного ширине вектора
+void IndexScalar(const char* begin, size_t pos, size_t end, std::vector<uint32_t>& out) {
+    for (; pos < end; ++pos) {
+        if (IsStructural(begin[pos])) {
+            out.push_back(static_cast<uint32_t>(pos));
+        }
+    }
+}
+
+const char* SkipScalar(const char* pos, const char* end) {
+    while (pos != end && IsSpace(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
+
+// Записывает позиции установленных битов mask, смещённые на base
+void AppendBits(uint32_t mask, size_t base, std::vector<uint32_t>& out) {
+    while (mask != 0) {
+        out.push_back(static_cast<uint32_t>(base + __builtin_ctz(mask)));
+        mask &= mask - 1;
+    }
+}
+
+#ifdef JSON_SCAN_X86
+
+void IndexSse2(const char* begin, size_t size, std::vector<uint32_t>& out) {
+    const __m128i chars[] = {
+        _mm_set1_epi8('{'), _mm_set1_epi8('}'), _mm_set1_epi8('['), _mm_set1_epi8(']'),
+        _mm_set1_epi8(':'), _mm_set1_epi8(','), _mm_set1_epi8('"'), _mm_set1_epi8('\\'),
+    };
+    size_t pos = 0;
+    for (; pos + 16 <= size; pos += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + pos));
+        __m128i hits = _mm_cmpeq_epi8(block, chars[0]);
+        for (int i = 1; i < 8; ++i) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, chars[i]));
+        }
+        AppendBits(static_cast<uint32_t>(_mm_movemask_epi8(hits)), pos, out);
+    }
+    IndexScalar(begin, pos, size, out);
+}
+
+const char* SkipSse2(const char* pos, const char* end) {
+    //короткие промежутки между лексемами выгоднее пройти без векторов
+    for (int i = 0; i < 4; ++i) {
+        if (pos == end || !IsSpace(*pos)) {
+            return pos;
+        }
+        ++pos;
+    }
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (end - pos >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, newline));
+        spaces = _mm_or_si128(spaces, _mm_or_si128(_mm_cmpeq_epi8(block, cr), _mm_cmpeq_epi8(block, tab)));
+        const uint32_t other = ~static_cast<uint32_t>(_mm_movemask_epi8(spaces)) & 0xFFFF;
+        if (other != 0) {
+            //\v и \f векторная часть не распознаёт, их досматривает скалярный цикл
+            return SkipScalar(pos + __builtin_ctz(other), end);
+        }
+        pos += 16;
+    }
+    return SkipScalar(pos, end);
+}
+
+__attribute__((target("avx2")))
+void IndexAvx2(const char* begin, size_t size, std::vector<uint32_t>& out) {
+    const __m256i chars[] = {
+        _mm256_set1_epi8('{'), _mm256_set1_epi8('}'), _mm256_set1_epi8('['), _mm256_set1_epi8(']'),
+        _mm256_set1_epi8(':'), _mm256_set1_epi8(','), _mm256_set1_epi8('"'), _mm256_set1_epi8('\\'),
+    };
+    size_t pos = 0;
+    for (; pos + 32 <= size; pos += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin + pos));
+        __m256i hits = _mm256_cmpeq_epi8(block, chars[0]);
+        for (int i = 1; i < 8; ++i) {
+            hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, chars[i]));
+        }
+        AppendBits(static_cast<uint32_t>(_mm256_movemask_epi8(hits)), pos, out);
+    }
+    IndexScalar(begin, pos, size, out);
+}
+
+#endif
+
+struct Backend {
+    const char* name;
+    void (*index)(const char* begin, size_t size, std::vector<uint32_t>& out);
+    const char* (*skip)(const char* pos, const char* end);
+};
+
+Backend SelectBackend() {
+#ifdef JSON_SCAN_X86
+    if (__builtin_cpu_supports("avx2")) {
+        //пропуск пробелов короткий, на нём AVX2 не выигрывает у SSE2
+        return {"avx2", IndexAvx2, SkipSse2};
+    }
+    return {"sse2", IndexSse2, SkipSse2};
+#else
+    return {"scalar", [](const char* begin, size_t size, std::vector<uint32_t>& out) {
+                IndexScalar(begin, 0, size, out);
+            }, SkipScalar};
+#endif
+}
+
+const Backend& GetBackend() {
+    static const Backend backend = SelectBackend();
+    return backend;
+}
+
+}  // namespace
+
+StructuralIndex IndexStructurals(std::string_view text) {
+    StructuralIndex result;
+    if (text.size() >= std::numeric_limits<uint32_t>::max()) {
+        result.failed = true;
+        return result;
+    }
+    //в типичном JSON структурный символ приходится примерно на каждые 6-8 байт
+    result.positions.reserve(text.size() / 6 + 16);
+    GetBackend().index(text.data(), text.size(), result.positions);
+    return result;
+}
+
+const char* SkipWhitespace(const char* pos, const char* end) {
+    return GetBackend().skip(pos, end);
+}
+
+const char* GetScanBackend() {
+    return GetBackend().name;
+}
+
+}  // namespace json::detail
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Первый, векторизованный проход разбора JSON. Реализация выбирается при запуске
+// по возможностям процессора: AVX2, SSE2 или скалярная.
+namespace json::detail {
+
+// Позиции символов { } [ ] : , " и \ в text по возрастанию, включая стоящие внутри строк.
+// Позиции 32-битные, поэтому для текста от 4 ГиБ индекс не строится и failed == true
+struct StructuralIndex {
+    std::vector<uint32_t> positions;
+    bool failed = false;
+};
+StructuralIndex IndexStructurals(std::string_view text);
+
+// Первый непробельный символ в [pos, end) или end
+const char* SkipWhitespace(const char* pos, const char* end);
+
+// Название выбранной реализации: "avx2", "sse2" или "scalar"
+const char* GetScanBackend();
+
+// Лексический уровень разбора JSON из непрерывного буфера, общий для всех видов DOM.
+// Курсор - указатель на очередной символ, поэтому чтение символа не проходит через
+// потоки и их локаль. Конец строки ищется по индексу структурных символов,
+// а пробелы пропускаются блоками. Error - тип исключения для ошибок разбора
+template <typename Error>
+class Scanner {
+public:
+    explicit Scanner(std::string_view text)
+        : begin_(text.data())
+        , pos_(text.data())
+        , end_(text.data() + text.size())
+        , index_(IndexStructurals(text)) {
+    }
+
+protected:
+    struct Number {
+        bool is_int;
+        int int_value;
+        double double_value;
+    };
+
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+    StructuralIndex index_;
+    //первый элемент индекса, который ещё может оказаться не раньше pos_
+    size_t next_ = 0;
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    static bool IsDigit(int c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // Верхняя оценка числа значений в тексте: каждое значение, кроме корневого,
+    // стоит после ':', ',' или '['. Без индекса - 0
+    size_t EstimateValueCount() const {
+        if (index_.failed) {
+            return 0;
+        }
+        size_t count = 1;
+        for (uint32_t pos : index_.positions) {
+            const char c = begin_[pos];
+            count += c == ':' || c == ',' || c == '[';
+        }
+        return count;
+    }
+
+    // Следующий символ или EOF в конце буфера
+    int Peek() const {
+        return pos_ != end_ ? static_cast<unsigned char>(*pos_) : EOF;
+    }
+
+    // Аналог input >> c: пропускает пробельные символы и читает следующий
+    bool ReadChar(char& c) {
+        if (pos_ != end_ && IsSpace(*pos_)) {
+            pos_ = SkipWhitespace(pos_ + 1, end_);
+        }
+        if (pos_ == end_) {
+            return false;
+        }
+        c = *pos_++;
+        return true;
+    }
+
+    std::string_view LoadLiteral() {
+        const char* begin = pos_;
+        while (pos_ != end_ && std::isalpha(static_cast<unsigned char>(*pos_))) {
+            ++pos_;
+        }
+        return {begin, static_cast<size_t>(pos_ - begin)};
+    }
+
+    // Ближайшая с pos_ кавычка или обратная косая черта, либо end_
+    const char* FindQuoteOrEscape() {
+        if (index_.failed) {
+            const char* pos = pos_;
+            while (pos != end_ && *pos != '"' && *pos != '\\') {
+                ++pos;
+            }
+            return pos;
+        }
+        const std::vector<uint32_t>& positions = index_.positions;
+        const size_t offset = static_cast<size_t>(pos_ - begin_);
+        while (next_ < positions.size() && positions[next_] < offset) {
+            ++next_;
+        }
+        for (; next_ < positions.size(); ++next_) {
+            const char c = begin_[positions[next_]];
+            if (c == '"' || c == '\\') {
+                return begin_ + positions[next_];
+            }
+        }
+        return end_;
+    }
+
+    // Читает строку после открывающей кавычки. Строка без экранирования возвращается
+    // как участок буфера, иначе раскодируется в decoded, и возвращается вид на него
+    std::string_view ScanString(std::string& decoded) {
+        using namespace std::literals;
+        bool escaped = false;
+        while (true) {
+            // обычные символы переносятся целыми участками
+            const char* begin = pos_;
+            const char* special = FindQuoteOrEscape();
+            pos_ = std::find_if(pos_, special, [](char c) {
+                return c == '\n' || c == '\r';
+            });
+            if (pos_ == end_) {
+                throw Error("String parsing error");
+            }
+            const char ch = *pos_++;
+            if (ch == '"') {
+                if (!escaped) {
+                    return {begin, static_cast<size_t>(pos_ - 1 - begin)};
+                }
+                decoded.append(begin, pos_ - 1);
+                return decoded;
+            } else if (ch == '\\') {
+                if (!escaped) {
+                    decoded.clear();
+                    escaped = true;
+                }
+                decoded.append(begin, pos_ - 1);
+                if (pos_ == end_) {
+                    throw Error("String parsing error");
+                }
+                const char escaped_char = *pos_++;
+                switch (escaped_char) {
+                    case 'n':
+                        decoded.push_back('\n');
+                        break;
+                    case 't':
+                        decoded.push_back('\t');
+                        break;
+                    case 'r':
+                        decoded.push_back('\r');
+                        break;
+                    case '"':
+                        decoded.push_back('"');
+                        break;
+                    case '\\':
+                        decoded.push_back('\\');
+                        break;
+                    default:
+                        throw Error("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            } else {
+                throw Error("Unexpected end of line"s);
+            }
+        }
+    }
+
+    // Число преобразуется прямо из буфера, без временной строки и исключений.
+    // Целое, не помещающееся в int, становится double
+    Number ScanNumber() {
+        using namespace std::literals;
+        const char* begin = pos_;
+
+        // Пропускает одну или более цифр
+        auto read_digits = [this] {
+            if (!IsDigit(Peek())) {
+                throw Error("A digit is expected"s);
+            }
+            while (IsDigit(Peek())) {
+                ++pos_;
+            }
+        };
+
+        if (Peek() == '-') {
+            ++pos_;
+        }
+        // Парсим целую часть числа
+        if (Peek() == '0') {
+            ++pos_;
+            // После 0 в JSON не могут идти другие цифры
+        } else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        // Парсим дробную часть числа
+        if (Peek() == '.') {
+            ++pos_;
+            read_digits();
+            is_int = false;
+        }
+
+        // Парсим экспоненциальную часть числа
+        if (int ch = Peek(); ch == 'e' || ch == 'E') {
+            ++pos_;
+            if (ch = Peek(); ch == '+' || ch == '-') {
+                ++pos_;
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        if (is_int) {
+            int value = 0;
+            if (auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{} && ptr == pos_) {
+                return {true, value, 0.0};
+            }
+        }
+        double value = 0;
+        if (auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{} && ptr == pos_) {
+            return {false, 0, value};
+        }
+        throw Error("Failed to convert "s + std::string(begin, pos_) + " to number"s);
+    }
+};
+
+}  // namespace json::detail
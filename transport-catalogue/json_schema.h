@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Типизированный разбор JSON по описанию полей. Для структуры T специализируется
+// Schema<T> со статической функцией Fields(), возвращающей кортеж MakeField(ключ, &T::поле).
+// Decode<T>(node) заполняет поля прямо из узла, без промежуточных копий и временных
+// строк-ключей. Узел - json::Node или json::compact::Node: оба дают одинаковые
+// Is*/As*, а словарь ищет ключ по std::string_view.
+namespace json::schema {
+
+template <typename T>
+struct Schema;
+
+// Разбор значения типа M. Для типов без Schema специализируется отдельно
+template <typename M, typename Enable = void>
+struct Decoder;
+
+// Описание поля: ключ JSON, член структуры и способ разбора значения.
+// Поле типа std::optional необязательное, отсутствие остальных - std::out_of_range
+template <typename T, typename M, typename Convert>
+struct Field {
+    std::string_view key;
+    M T::*member;
+};
+
+// Convert по умолчанию - Decoder<M>; свой задаётся явно, например для цвета,
+// который хранится строкой, но в JSON может быть массивом
+template <typename Convert = void, typename T, typename M>
+constexpr auto MakeField(std::string_view key, M T::*member) {
+    using Used = std::conditional_t<std::is_void_v<Convert>, Decoder<M>, Convert>;
+    return Field<T, M, Used>{key, member};
+}
+
+template <typename T, typename NodeT>
+T Decode(const NodeT& node) {
+    return Decoder<T>::Decode(node);
+}
+
+namespace detail {
+
+template <typename M>
+struct IsOptional : std::false_type {};
+template <typename M>
+struct IsOptional<std::optional<M>> : std::true_type {};
+
+template <typename DictT, typename T, typename M, typename Convert, typename Object>
+void DecodeField(const DictT& dict, const Field<T, M, Convert>& field, Object& object) {
+    using namespace std::literals;
+    auto it = dict.find(field.key);
+    if (it == dict.end()) {
+        if constexpr (IsOptional<M>::value) {
+            return;
+        } else {
+            throw std::out_of_range("json::schema: no key "s + std::string(field.key));
+        }
+    }
+    object.*field.member = Convert::Decode((*it).second);
+}
+
+}  // namespace detail
+
+// Структура с описанием полей; незнакомые ключи пропускаются
+template <typename T, typename Enable>
+struct Decoder {
+    template <typename NodeT>
+    static T Decode(const NodeT& node) {
+        T result{};
+        const auto& dict = node.AsDict();
+        std::apply([&dict, &result](const auto&... fields) {
+            (detail::DecodeField(dict, fields, result), ...);
+        }, Schema<T>::Fields());
+        return result;
+    }
+};
+
+template <>
+struct Decoder<int> {
+    template <typename NodeT>
+    static int Decode(const NodeT& node) {
+        return node.AsInt();
+    }
+};
+
+// Беззнаковое целое; отрицательное значение - std::out_of_range, а не огромное число
+template <typename U>
+struct UnsignedDecoder {
+    template <typename NodeT>
+    static U Decode(const NodeT& node) {
+        using namespace std::literals;
+        const int value = node.AsInt();
+        if (value < 0) {
+            throw std::out_of_range("json::schema: negative value "s + std::to_string(value));
+        }
+        return static_cast<U>(value);
+    }
+};
+
+template <>
+struct Decoder<uint32_t> : UnsignedDecoder<uint32_t> {};
+
+template <>
+struct Decoder<size_t> : UnsignedDecoder<size_t> {};
+
+template <>
+struct Decoder<double> {
+    template <typename NodeT>
+    static double Decode(const NodeT& node) {
+        return node.AsDouble();
+    }
+};
+
+template <>
+struct Decoder<bool> {
+    template <typename NodeT>
+    static bool Decode(const NodeT& node) {
+        return node.AsBool();
+    }
+};
+
+template <>
+struct Decoder<std::string> {
+    template <typename NodeT>
+    static std::string Decode(const NodeT& node) {
+        return std::string(node.AsString());
+    }
+};
+
+// Вид на строку в документе: документ должен жить дольше результата
+template <>
+struct Decoder<std::string_view> {
+    template <typename NodeT>
+    static std::string_view Decode(const NodeT& node) {
+        return node.AsString();
+    }
+};
+
+template <typename M>
+struct Decoder<std::optional<M>> {
+    template <typename NodeT>
+    static std::optional<M> Decode(const NodeT& node) {
+        return Decoder<M>::Decode(node);
+    }
+};
+
+// Массив, элементы которого разбирает ItemDecoder
+template <typename ItemDecoder>
+struct ArrayOf {
+    template <typename NodeT>
+    static auto Decode(const NodeT& node) {
+        std::vector<decltype(ItemDecoder::Decode(node))> result;
+        const auto& array = node.AsArray();
+        result.reserve(array.size());
+        for (const auto& item : array) {
+            result.push_back(ItemDecoder::Decode(item));
+        }
+        return result;
+    }
+};
+
+template <typename M>
+struct Decoder<std::vector<M>> : ArrayOf<Decoder<M>> {};
+
+// Словарь разбирается в пары ключ-значение по возрастанию ключа
+template <typename M>
+struct Decoder<std::vector<std::pair<std::string_view, M>>> {
+    template <typename NodeT>
+    static std::vector<std::pair<std::string_view, M>> Decode(const NodeT& node) {
+        std::vector<std::pair<std::string_view, M>> result;
+        const auto& dict = node.AsDict();
+        result.reserve(dict.size());
+        for (const auto& [key, value] : dict) {
+            result.emplace_back(key, Decoder<M>::Decode(value));
+        }
+        return result;
+    }
+};
+
+}  // namespace json::schema
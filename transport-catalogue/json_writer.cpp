@@ -0,0 +1,191 @@
+#include "json_writer.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+
+namespace json {
+
+using namespace std::literals;
+
+namespace {
+
+constexpr int INDENT_STEP = 4;
+
+}  // namespace
+
+Writer::Writer(PrintStyle style)
+    : style_(style) {
+}
+
+Writer::Writer(std::ostream& out, PrintStyle style)
+    : out_(&out)
+    , style_(style) {
+    buffer_.reserve(FLUSH_SIZE * 2);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+void Writer::Write(const Node& node) {
+    WriteNode(node, BeginElement());
+}
+
+void Writer::StartArray() {
+    BeginElement();
+    buffer_.push_back('[');
+    open_arrays_.push_back(true);
+}
+
+void Writer::EndArray() {
+    if (open_arrays_.empty()) {
+        throw std::logic_error("json::Writer: EndArray without StartArray"s);
+    }
+    if (open_arrays_.back()) {
+        NewLine(0);
+    }
+    open_arrays_.pop_back();
+    NewLine(static_cast<int>(open_arrays_.size()) * INDENT_STEP);
+    buffer_.push_back(']');
+    FlushIfFull();
+}
+
+void Writer::Flush() {
+    if (out_) {
+        WriteBuffer();
+        out_->flush();
+    }
+}
+
+std::string Writer::TakeBuffer() {
+    std::string result = std::move(buffer_);
+    buffer_.clear();
+    return result;
+}
+
+int Writer::BeginElement() {
+    const int indent = static_cast<int>(open_arrays_.size()) * INDENT_STEP;
+    if (!open_arrays_.empty()) {
+        if (!open_arrays_.back()) {
+            buffer_.push_back(',');
+        }
+        open_arrays_.back() = false;
+        NewLine(indent);
+    }
+    return indent;
+}
+
+void Writer::FlushIfFull() {
+    if (out_ && buffer_.size() >= FLUSH_SIZE) {
+        WriteBuffer();
+    }
+}
+
+void Writer::WriteBuffer() {
+    if (!buffer_.empty()) {
+        out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+}
+
+void Writer::NewLine(int indent) {
+    if (style_ == PrintStyle::PRETTY) {
+        buffer_.push_back('\n');
+        buffer_.append(static_cast<size_t>(indent), ' ');
+    }
+}
+
+void Writer::WriteNode(const Node& node, int indent) {
+    std::visit([this, indent](const auto& value) {
+        using T = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<T, std::nullptr_t>) {
+            buffer_ += "null"sv;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            buffer_ += value ? "true"sv : "false"sv;
+        } else if constexpr (std::is_same_v<T, int>) {
+            WriteInt(value);
+        } else if constexpr (std::is_same_v<T, double>) {
+            WriteDouble(value);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            WriteString(value);
+        } else if constexpr (std::is_same_v<T, Array>) {
+            WriteArray(value, indent);
+        } else {
+            WriteDict(value, indent);
+        }
+    }, node.GetValue());
+    FlushIfFull();
+}
+
+// Пустой контейнер в PRETTY выводится, как и прежде, с пустой строкой внутри
+void Writer::WriteArray(const Array& nodes, int indent) {
+    buffer_.push_back('[');
+    bool first = true;
+    for (const Node& node : nodes) {
+        if (!first) {
+            buffer_.push_back(',');
+        }
+        first = false;
+        NewLine(indent + INDENT_STEP);
+        WriteNode(node, indent + INDENT_STEP);
+    }
+    if (first) {
+        NewLine(0);
+    }
+    NewLine(indent);
+    buffer_.push_back(']');
+}
+
+void Writer::WriteDict(const Dict& nodes, int indent) {
+    buffer_.push_back('{');
+    bool first = true;
+    for (const auto& [key, node] : nodes) {
+        if (!first) {
+            buffer_.push_back(',');
+        }
+        first = false;
+        NewLine(indent + INDENT_STEP);
+        WriteString(key);
+        buffer_ += style_ == PrintStyle::PRETTY ? ": "sv : ":"sv;
+        WriteNode(node, indent + INDENT_STEP);
+    }
+    if (first) {
+        NewLine(0);
+    }
+    NewLine(indent);
+    buffer_.push_back('}');
+}
+
+void Writer::WriteString(std::string_view value) {
+    buffer_.push_back('"');
+    size_t plain = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        if (c != '\r' && c != '\n' && c != '"' && c != '\\') {
+            continue;
+        }
+        //участки без спецсимволов копируются целиком
+        buffer_.append(value.data() + plain, i - plain);
+        plain = i + 1;
+        buffer_.push_back('\\');
+        buffer_.push_back(c == '\r' ? 'r' : c == '\n' ? 'n' : c);
+    }
+    buffer_.append(value.data() + plain, value.size() - plain);
+    buffer_.push_back('"');
+}
+
+void Writer::WriteInt(int value) {
+    char chars[16];
+    auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), value);
+    buffer_.append(chars, end);
+}
+
+void Writer::WriteDouble(double value) {
+    char chars[32];
+    auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), value);
+    buffer_.append(chars, end);
+}
+
+}  // namespace json
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.h"
+
+// Буферизованный вывод JSON. Токены дописываются в растущий буфер без потоков и их
+// локали, числа форматируются std::to_chars: целые как есть, double - кратчайшей
+// записью, которая читается обратно в то же значение. С потоком буфер сбрасывается
+// в него блоками от FLUSH_SIZE байт, без потока результат забирается TakeBuffer().
+// Массив можно выводить по элементам: StartArray(), Write() на каждый
+// элемент, EndArray(). Тогда в памяти держится не больше блока и текущего элемента
+namespace json {
+
+class Writer {
+public:
+    static constexpr size_t FLUSH_SIZE = 1 << 16;
+
+    explicit Writer(PrintStyle style = PrintStyle::PRETTY);
+    explicit Writer(std::ostream& out, PrintStyle style = PrintStyle::PRETTY);
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+    // дописывает в поток остаток буфера
+    ~Writer();
+
+    // значение целиком или очередной элемент открытого StartArray() массива
+    void Write(const Node& node);
+    void StartArray();
+    void EndArray();
+    // отдаёт буфер в поток целиком и сбрасывает поток; без потока ничего не делает.
+    // Между блоками поток не сбрасывается: каждый сброс в канал - отдельная запись
+    void Flush();
+    // накопленный текст; буфер после этого пуст
+    std::string TakeBuffer();
+
+private:
+    std::ostream* out_ = nullptr;
+    PrintStyle style_;
+    std::string buffer_;
+    //открытые StartArray() массивы: пуст ли ещё каждый из них
+    std::vector<bool> open_arrays_;
+
+    // запятая и отступ перед элементом открытого массива; возвращает отступ элемента
+    int BeginElement();
+    void WriteNode(const Node& node, int indent);
+    void WriteArray(const Array& nodes, int indent);
+    void WriteDict(const Dict& nodes, int indent);
+    void WriteString(std::string_view value);
+    void WriteInt(int value);
+    void WriteDouble(double value);
+    // перевод строки и отступ перед элементом или закрывающей скобкой, только в PRETTY
+    void NewLine(int indent);
+    // отдаёт буфер в поток, если в нём набралось FLUSH_SIZE байт
+    void FlushIfFull();
+    void WriteBuffer();
+};
+
+}  // namespace json
@@ -1,12 +1,19 @@
 #include <algorithm>
 #include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "catalogue_image.h"
+#include "catalogue_snapshot.h"
 #include "map_renderer.h"
 #include "json_reader.h"
+#include "mapped_file.h"
 #include "request_handler.h"
 #include "transport_catalogue.h"
+#include "transport_router.h"
 
 using std::string, std::string_view, std::vector, std::cout, std::endl;
 using namespace std::literals;
@@ -14,15 +21,116 @@ using namespace ctlg;
 using namespace renderer;
 
 
-int main() {
-    TransportCatalogue catalogue;
-    RenderSettings sett;
-    RequestHandler handler{catalogue};
-    ctlg::jreader::JsonReader jreader(handler, std::cin);
-    jreader.ApplyCommands();
-    MapRenderer rend{jreader.GetRendererSettings()};
-    auto routes = handler.GetRoutes();
-    rend.SetRoutes(routes);
-    cout << jreader.GetStats();
+// Режимы запуска:
+//   без аргументов                 - base_requests и stat_requests из stdin
+//   --export-image <file> [<routes>] - загрузить base_requests из stdin и сохранить образ справочника,
+//                                      а с <routes> - ещё и таблицу маршрутов
+//   --image <file> [<routes>]        - взять справочник из образа, из stdin - только настройки и stat_requests;
+//                                      с <routes> таблица маршрутов подключается из файла, а не строится
+// Образ и таблица отображаются в память только для чтения, поэтому рабочие процессы,
+// запущенные с одними и теми же файлами на tmpfs, делят их страницы.
+// Флаг --memory-report в любом режиме ответов печатает в stderr отчёт о памяти структур.
+// С --input <json> запросы читаются не из stdin, а из файла, отображённого в память.
+// С --parallel base_requests разбираются и загружаются по частям на всех ядрах,
+// иначе применяются потоково по ходу разбора с наименьшим расходом памяти.
+// С --compact ответы печатаются одной строкой, без пробелов и отступов.
+int main(int argc, char* argv[]) {
+    vector<string> args(argv + 1, argv + argc);
+    auto report_flag = std::find(args.begin(), args.end(), "--memory-report"s);
+    const bool memory_report = report_flag != args.end();
+    if(memory_report){
+        args.erase(report_flag);
+    }
+    auto parallel_flag = std::find(args.begin(), args.end(), "--parallel"s);
+    const bool parallel = parallel_flag != args.end();
+    if(parallel){
+        args.erase(parallel_flag);
+    }
+    auto compact_flag = std::find(args.begin(), args.end(), "--compact"s);
+    const auto output_style = compact_flag != args.end() ? json::PrintStyle::COMPACT : json::PrintStyle::PRETTY;
+    if(compact_flag != args.end()){
+        args.erase(compact_flag);
+    }
+    std::unique_ptr<MappedFile> input_file;
+    if(auto input_flag = std::find(args.begin(), args.end(), "--input"s); input_flag != args.end()){
+        if(std::next(input_flag) == args.end()){
+            std::cerr << "--input requires a file name"sv << endl;
+            return 1;
+        }
+        try{
+            input_file = std::make_unique<MappedFile>(*std::next(input_flag));
+        } catch(const std::exception& e){
+            std::cerr << e.what() << endl;
+            return 1;
+        }
+        args.erase(input_flag, input_flag + 2);
+    }
+    const string mode = args.size() == 2 || args.size() == 3 ? args[0] : ""s;
+    const string routes_path = args.size() == 3 ? args[2] : ""s;
+    if(!args.empty() && mode != "--export-image"s && mode != "--image"s){
+        std::cerr << "Usage: "sv << argv[0]
+                  << " [--export-image <file> [<routes>] | --image <file> [<routes>]] [--input <json>] [--parallel] [--compact] [--memory-report]"sv << endl;
+        return 1;
+    }
+    std::unique_ptr<TransportCatalogue> catalogue;
+    try{
+        catalogue = mode == "--image"s ? CatalogueImage::Load(args[1]) : std::make_unique<TransportCatalogue>();
+    } catch(const std::exception& e){
+        std::cerr << e.what() << endl;
+        return 1;
+    }
+    RequestHandler handler{*catalogue};
+    //справочник из образа уже готов, иначе base_requests применяются прямо при разборе
+    const auto input_mode = mode == "--image"s ? ctlg::jreader::InputMode::DOCUMENT
+                          : parallel ? ctlg::jreader::InputMode::PARALLEL
+                                     : ctlg::jreader::InputMode::STREAM;
+    ctlg::jreader::JsonReader jreader = input_file
+        ? ctlg::jreader::JsonReader(handler, string_view{input_file->Data(), input_file->Size()}, input_mode)
+        : ctlg::jreader::JsonReader(handler, std::cin, input_mode);
+    if(mode == "--image"s){
+        handler.UpdateBusStats();
+        handler.FreezeCatalogue();
+    } else {
+        jreader.ApplyCommands();
+    }
+    if(mode == "--export-image"s){
+        try{
+            std::ofstream out(args[1], std::ios::binary);
+            CatalogueImage::Save(*catalogue, out);
+            if(!routes_path.empty()){
+                transport_router router{*catalogue, jreader.GetRoutingSettings()};
+                router.CreateAllData();
+                router.SaveRoutes(routes_path);
+            }
+        } catch(const std::exception& e){
+            std::cerr << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+    auto print_memory_report = [&jreader, memory_report](const TransportCatalogue& db, const transport_router* router,
+                                                         const string* map){
+        if(memory_report){
+            json::Print(json::Document{jreader.MemoryReportToJson(jreader.GetMemoryReport(db, router, map))}, std::cerr);
+            std::cerr << endl;
+        }
+    };
+    // Пакет с изменениями справочника обслуживается без неизменяемого снимка
+    if(jreader.HasUpdateRequests()){
+        jreader.WriteStats(cout, output_style);
+        print_memory_report(*catalogue, nullptr, nullptr);
+        return 0;
+    }
+    SnapshotHolder snapshots;
+    try{
+        snapshots.Publish(std::make_shared<const CatalogueSnapshot>(
+            std::move(catalogue), jreader.GetRoutingSettings(), jreader.GetRendererSettings(), routes_path));
+    } catch(const std::exception& e){
+        //таблица маршрутов не подходит к справочнику или повреждена
+        std::cerr << e.what() << endl;
+        return 1;
+    }
+    jreader.WriteStats(*snapshots.Get(), cout, output_style);
+    print_memory_report(snapshots.Get()->GetCatalogue(), &snapshots.Get()->GetRouter(), snapshots.Get()->GetRenderedMap());
     return 0;
 }
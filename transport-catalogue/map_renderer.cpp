@@ -6,23 +6,48 @@ namespace renderer {
 
 using namespace svg;
 
-void MapRenderer::SetRoutes(vector<std::pair<string_view, Bus*>> routes){
+void MapRenderer::SetRoutes(vector<std::pair<string_view, const Bus*>> routes, const std::deque<Stop>& stops){
     routes_ = routes;
+    stops_ = &stops;
 }
 
 vector<vector<geo::Coordinates>> MapRenderer::GetAllPoints() {
     vector<vector<geo::Coordinates>> lines;
     for( auto route : routes_){
-        Bus *bus = route.second;
+        const Bus *bus = route.second;
         vector<geo::Coordinates> line;
-        for( auto stop : bus->stops_){
-            line.push_back(stop->coord_);
+        for( StopId stop : bus->GetRoute()){
+            line.push_back((*stops_)[stop].coord_);
         }
         lines.push_back(line);
     }
     return lines;
 }
 
+void MapRenderer::SetViewport(const Viewport& viewport){
+    viewport_ = viewport;
+    visible_stops_ = {viewport.stops.begin(), viewport.stops.end()};
+}
+
+bool MapRenderer::IsVisible(const vector<geo::Coordinates>& route) const{
+    if(!viewport_){
+        return true;
+    }
+    if(route.empty()){
+        return false;
+    }
+    auto [min_lat, max_lat] = std::minmax_element(route.begin(), route.end(),
+        [](const auto& lhs, const auto& rhs){ return lhs.lat < rhs.lat; });
+    auto [min_lng, max_lng] = std::minmax_element(route.begin(), route.end(),
+        [](const auto& lhs, const auto& rhs){ return lhs.lng < rhs.lng; });
+    return min_lat->lat <= viewport_->max.lat && max_lat->lat >= viewport_->min.lat
+        && min_lng->lng <= viewport_->max.lng && max_lng->lng >= viewport_->min.lng;
+}
+
+bool MapRenderer::IsVisible(const Stop* stop) const{
+    return !viewport_ || visible_stops_.count(stop);
+}
+
 svg::Color MapRenderer::RouteNumerToColor(size_t number) {
     size_t index = number % settings_.color_palette.size();
     return settings_.color_palette[index];
@@ -52,6 +77,13 @@ svg::Document& MapRenderer::RenderRouts(
     size_t colors = settings_.color_palette.size();
     size_t color_index = 0;
     for( auto route : routes){
+        if(!IsVisible(route)){
+            //цвет пропущенного маршрута не достаётся следующему
+            if(++color_index >= colors){
+                color_index = 0;
+            }
+            continue;
+        }
         Polyline line;
         for(auto p : route){
             line.AddPoint(proj(p));
@@ -73,64 +105,48 @@ svg::Document& MapRenderer::RenderRouts(
     return svg_doc;
 }
 
+void MapRenderer::RenderBusName(string_view bus_name, const Stop& stop, size_t route_num,
+                                SphereProjector& proj, svg::Document& svg_doc){
+    svg::Text underline;
+    underline.SetData(string(bus_name))
+    .SetFillColor(settings_.underlayer_color)
+    .SetStrokeColor(settings_.underlayer_color)
+    .SetStrokeWidth(settings_.underlayer_width)
+    .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+    .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
+    .SetPosition(proj(stop.coord_))
+    .SetOffset(settings_.bus_label_offset)
+    .SetFontSize(settings_.bus_label_font_size)
+    .SetFontFamily("Verdana"s)
+    .SetFontWeight("bold"s);
+
+    svg::Text label;
+    label.SetData(string(bus_name))
+    .SetFillColor(RouteNumerToColor(route_num))
+    .SetPosition(proj(stop.coord_))
+    .SetOffset(settings_.bus_label_offset)
+    .SetFontSize(settings_.bus_label_font_size)
+    .SetFontFamily("Verdana"s)
+    .SetFontWeight("bold"s);
+
+    svg_doc.Add(underline);
+    svg_doc.Add(label);
+}
+
 svg::Document& MapRenderer::RenderBusNames(SphereProjector& proj, svg::Document& svg_doc){
     size_t route_num = 0;
     for(auto [bus_name, bus] : routes_){
         if(bus->stops_.size() == 0) {
             continue;
         }
-        svg::Text first_underline;
-        first_underline.SetData(string(bus_name))
-        .SetFillColor(settings_.underlayer_color)
-        .SetStrokeColor(settings_.underlayer_color)
-        .SetStrokeWidth(settings_.underlayer_width)
-        .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-        .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
-        .SetPosition(proj(bus->stops_[0]->coord_))
-        .SetOffset(settings_.bus_label_offset)
-        .SetFontSize(settings_.bus_label_font_size)
-        .SetFontFamily("Verdana"s)
-        .SetFontWeight("bold"s);
-
-        svg::Text fist_label;
-        fist_label.SetData(string(bus_name))
-        .SetFillColor(RouteNumerToColor(route_num))
-        .SetPosition(proj(bus->stops_[0]->coord_))
-        .SetOffset(settings_.bus_label_offset)
-        .SetFontSize(settings_.bus_label_font_size)
-        .SetFontFamily("Verdana"s)
-        .SetFontWeight("bold"s);
-
-        svg_doc.Add(first_underline);
-        svg_doc.Add(fist_label);
-
+        const Stop& first_stop = (*stops_)[bus->stops_[0]];
+        if(IsVisible(&first_stop)){
+            RenderBusName(bus_name, first_stop, route_num, proj, svg_doc);
+        }
         if(!bus->IsRound()){
-            Stop *last_stop = bus->GetLastStop();
-            if(last_stop != bus->stops_[0]){
-                svg::Text last_underline;
-                last_underline.SetData(string(bus_name))
-                .SetFillColor(settings_.underlayer_color)
-                .SetStrokeColor(settings_.underlayer_color)
-                .SetStrokeWidth(settings_.underlayer_width)
-                .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
-                .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
-                .SetPosition(proj(last_stop->coord_))
-                .SetOffset(settings_.bus_label_offset)
-                .SetFontSize(settings_.bus_label_font_size)
-                .SetFontFamily("Verdana"s)
-                .SetFontWeight("bold"s);
-
-                svg::Text last_label;
-                last_label.SetData(string(bus_name))
-                .SetFillColor(RouteNumerToColor(route_num))
-                .SetPosition(proj(last_stop->coord_))
-                .SetOffset(settings_.bus_label_offset)
-                .SetFontSize(settings_.bus_label_font_size)
-                .SetFontFamily("Verdana"s)
-                .SetFontWeight("bold"s);
-
-                svg_doc.Add(last_underline);
-                svg_doc.Add(last_label);
+            const Stop* last_stop = &(*stops_)[bus->GetLastStop()];
+            if(last_stop != &first_stop && IsVisible(last_stop)){
+                RenderBusName(bus_name, *last_stop, route_num, proj, svg_doc);
             }
         }
         ++route_num;
@@ -138,12 +154,18 @@ svg::Document& MapRenderer::RenderBusNames(SphereProjector& proj, svg::Document&
     return svg_doc;
 }
 
-vector<Stop*> MapRenderer::SortedRoutesStops() {
-    std::set<Stop*> routes_stops;
+vector<const Stop*> MapRenderer::SortedRoutesStops() {
+    std::set<StopId> routes_stops;
     for(auto route : routes_){
         routes_stops.insert(route.second->stops_.begin(), route.second->stops_.end());
     }
-    vector<Stop*> stops{routes_stops.begin(), routes_stops.end()};
+    vector<const Stop*> stops;
+    for(StopId id : routes_stops){
+        const Stop* stop = &(*stops_)[id];
+        if(IsVisible(stop)){
+            stops.push_back(stop);
+        }
+    }
     std::sort(stops.begin(), stops.end(),[](auto lhs, auto rhs){ return lhs->name_ < rhs->name_;});
     return stops;
 }
@@ -6,8 +6,10 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
 #include <optional>
+#include <unordered_set>
 #include <vector>
 
 using std::vector, std::string_view;
@@ -108,21 +110,41 @@ struct RenderSettings{
     std::vector<svg::Color> color_palette;
 };
 
+// Видимая область карты. Масштаб и цвета остаются как у всей карты, поэтому
+// фрагмент совпадает с соответствующей частью полной карты
+struct Viewport {
+    geo::Coordinates min;
+    geo::Coordinates max;
+    //остановки внутри области, например найденные TransportCatalogue::GetStopsInArea
+    vector<const Stop*> stops;
+};
+
 class MapRenderer {
 public:
     MapRenderer(const RenderSettings settings): settings_(settings){}
-    void SetRoutes(vector<std::pair<string_view, Bus*>> routes);
+    void SetRoutes(vector<std::pair<string_view, const Bus*>> routes, const std::deque<Stop>& stops);
+    //выводятся только линии маршрутов, чья рамка пересекает область,
+    //названия автобусов у конечных внутри неё и остановки viewport.stops
+    void SetViewport(const Viewport& viewport);
     svg::Document RenderMap();
 private:
     const RenderSettings settings_;
-    vector<std::pair<string_view, Bus*>> routes_;
+    vector<std::pair<string_view, const Bus*>> routes_;
+    //все остановки справочника, индексируются по StopId
+    const std::deque<Stop>* stops_ = nullptr;
+    std::optional<Viewport> viewport_;
+    std::unordered_set<const Stop*> visible_stops_;
 
     SphereProjector SetCoeffs(vector<vector<geo::Coordinates>>& routes);
     vector<vector<geo::Coordinates>> GetAllPoints();
     svg::Color RouteNumerToColor(size_t number);
+    bool IsVisible(const vector<geo::Coordinates>& route) const;
+    bool IsVisible(const Stop* stop) const;
     svg::Document& RenderRouts(vector<vector<geo::Coordinates>>& routes, SphereProjector& proj, svg::Document& svg_doc);
     svg::Document& RenderBusNames(SphereProjector& proj, svg::Document& svg_doc);
-    vector<Stop*> SortedRoutesStops();
+    void RenderBusName(string_view bus_name, const Stop& stop, size_t route_num,
+                       SphereProjector& proj, svg::Document& svg_doc);
+    vector<const Stop*> SortedRoutesStops();
     svg::Document& RenderStops(SphereProjector& proj, svg::Document& svg_doc);
 };
 
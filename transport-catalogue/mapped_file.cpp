@@ -0,0 +1,83 @@
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+using namespace std::literals;
+
+#ifdef _WIN32
+
+// Описатели файла и отображения закрываются сразу: представление держит их само
+MappedFile::MappedFile(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("MappedFile: cannot open "s + path);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("MappedFile: cannot stat "s + path);
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    //пустой файл отобразить нельзя
+    if (size_ > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* addr = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (!addr) {
+            CloseHandle(file);
+            throw std::runtime_error("MappedFile: cannot map "s + path);
+        }
+        data_ = static_cast<const char*>(addr);
+    }
+    CloseHandle(file);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("MappedFile: cannot open "s + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("MappedFile: cannot stat "s + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("MappedFile: cannot map "s + path);
+        }
+        data_ = static_cast<const char*>(addr);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+#endif
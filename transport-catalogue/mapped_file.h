@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+
+// Файл, отображённый в память только для чтения. Страницы разделяются
+// между всеми процессами, отобразившими тот же файл.
+class MappedFile {
+public:
+    // бросает std::runtime_error, если файл не удалось открыть или отобразить
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
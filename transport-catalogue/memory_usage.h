@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Память, которую занимает структура данных. Байты кучи считаются по ёмкостям
+// контейнеров и устройству libstdc++ (узлы хеш-таблиц и деревьев, блоки deque),
+// без служебных заголовков распределителя, поэтому это нижняя оценка.
+struct MemoryUsage {
+    size_t bytes = 0;
+    size_t allocations = 0;
+    // отображённые в память файлы: их страницы общие для всех процессов
+    size_t mapped_bytes = 0;
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        bytes += other.bytes;
+        allocations += other.allocations;
+        mapped_bytes += other.mapped_bytes;
+        return *this;
+    }
+};
+
+inline MemoryUsage operator+(MemoryUsage lhs, const MemoryUsage& rhs) {
+    return lhs += rhs;
+}
+
+// Именованные части, из которых складывается память процесса
+class MemoryReport {
+public:
+    void Add(const std::string& name, const MemoryUsage& usage) {
+        items_[name] += usage;
+    }
+    const std::map<std::string, MemoryUsage>& GetItems() const {
+        return items_;
+    }
+    MemoryUsage GetTotal() const {
+        MemoryUsage total;
+        for (const auto& [name, usage] : items_) {
+            total += usage;
+        }
+        return total;
+    }
+
+private:
+    std::map<std::string, MemoryUsage> items_;
+};
+
+// Оценки для стандартных контейнеров; память самих элементов вне контейнера не учитывается
+
+template <typename T, typename Alloc>
+MemoryUsage UsageOf(const std::vector<T, Alloc>& items) {
+    return {items.capacity() * sizeof(T), items.capacity() > 0 ? 1u : 0u};
+}
+
+template <typename Alloc>
+MemoryUsage UsageOf(const std::basic_string<char, std::char_traits<char>, Alloc>& str) {
+    static const size_t SSO_CAPACITY = std::basic_string<char, std::char_traits<char>, Alloc>{}.capacity();
+    if (str.capacity() <= SSO_CAPACITY) {
+        return {};
+    }
+    return {str.capacity() + 1, 1};
+}
+
+template <typename T>
+MemoryUsage UsageOf(const std::optional<T>& value) {
+    return value ? UsageOf(*value) : MemoryUsage{};
+}
+
+template <typename T, typename Alloc>
+MemoryUsage UsageOf(const std::deque<T, Alloc>& items) {
+    //libstdc++ хранит элементы блоками по 512 байт и массив указателей на блоки
+    constexpr size_t BLOCK_ITEMS = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+    const size_t blocks = items.size() / BLOCK_ITEMS + 1;
+    const size_t map_size = std::max<size_t>(8, blocks + 2);
+    return {blocks * BLOCK_ITEMS * sizeof(T) + map_size * sizeof(T*), blocks + 1};
+}
+
+template <typename Key, typename Value, typename Hash, typename Equal>
+MemoryUsage UsageOf(const std::unordered_map<Key, Value, Hash, Equal>& items) {
+    //узел: указатель на следующий, значение и сохранённый хеш
+    constexpr size_t NODE_SIZE = sizeof(void*) + sizeof(std::pair<const Key, Value>) + sizeof(size_t);
+    const size_t buckets = items.bucket_count() > 1 ? items.bucket_count() : 0;
+    return {items.size() * NODE_SIZE + buckets * sizeof(void*), items.size() + (buckets > 0 ? 1 : 0)};
+}
+
+template <typename Key, typename Value, typename Compare>
+MemoryUsage UsageOf(const std::map<Key, Value, Compare>& items) {
+    //узел красно-чёрного дерева: цвет и три указателя
+    constexpr size_t NODE_SIZE = 4 * sizeof(void*) + sizeof(std::pair<const Key, Value>);
+    return {items.size() * NODE_SIZE, items.size()};
+}
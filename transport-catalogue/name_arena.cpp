@@ -0,0 +1,28 @@
+#include <cstring>
+
+#include "name_arena.h"
+
+std::string_view NameArena::Store(std::string_view name) {
+    if (name.size() > block_free_) {
+        //длинные имена получают собственный блок, текущий блок продолжает заполняться
+        if (name.size() > BLOCK_SIZE / 4) {
+            blocks_.push_back(std::make_unique<char[]>(name.size()));
+            bytes_reserved_ += name.size();
+            std::memcpy(blocks_.back().get(), name.data(), name.size());
+            bytes_used_ += name.size();
+            return {blocks_.back().get(), name.size()};
+        }
+        blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+        bytes_reserved_ += BLOCK_SIZE;
+        block_pos_ = blocks_.back().get();
+        block_free_ = BLOCK_SIZE;
+    }
+    char* dst = block_pos_;
+    if (!name.empty()) {
+        std::memcpy(dst, name.data(), name.size());
+    }
+    block_pos_ += name.size();
+    block_free_ -= name.size();
+    bytes_used_ += name.size();
+    return {dst, name.size()};
+}
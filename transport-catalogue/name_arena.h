@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "memory_usage.h"
+
+// Хранилище имён остановок и автобусов. Строки складываются подряд в крупные блоки
+// и не перемещаются, поэтому выданные string_view остаются действительными,
+// пока жив сам NameArena.
+class NameArena {
+public:
+    NameArena() = default;
+    NameArena(const NameArena&) = delete;
+    NameArena& operator=(const NameArena&) = delete;
+
+    std::string_view Store(std::string_view name);
+    size_t GetBytesUsed() const { return bytes_used_; }
+    MemoryUsage GetMemoryUsage() const {
+        return MemoryUsage{bytes_reserved_, blocks_.size()} + UsageOf(blocks_);
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t block_free_ = 0;
+    char* block_pos_ = nullptr;
+    size_t bytes_used_ = 0;
+    size_t bytes_reserved_ = 0;
+};
@@ -0,0 +1,50 @@
+#include "name_index.h"
+
+namespace ctlg {
+
+void FrozenNameIndex::Build(const std::vector<std::pair<std::string_view, uint32_t>>& entries) {
+    //заполненность таблицы не превышает половины
+    size_t capacity = 16;
+    while (capacity < entries.size() * 2) {
+        capacity *= 2;
+    }
+    slots_.assign(capacity, Slot{});
+    used_ = entries.size();
+    for (const auto& [name, id] : entries) {
+        const uint64_t hash = Hash(name);
+        slots_[FindFreeSlot(hash)] = {Tag(hash), id};
+    }
+}
+
+void FrozenNameIndex::Clear() {
+    slots_.clear();
+    slots_.shrink_to_fit();
+    used_ = 0;
+}
+
+bool FrozenNameIndex::Erase(std::string_view name, uint32_t id) {
+    if (slots_.empty()) {
+        return false;
+    }
+    const uint64_t hash = Hash(name);
+    const size_t mask = slots_.size() - 1;
+    for (size_t index = hash & mask; slots_[index].id != EMPTY_ID; index = (index + 1) & mask) {
+        if (slots_[index].id == id) {
+            //цепочки поиска через эту ячейку не должны обрываться
+            slots_[index].id = ERASED_ID;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t FrozenNameIndex::FindFreeSlot(uint64_t hash) const {
+    const size_t mask = slots_.size() - 1;
+    size_t index = hash & mask;
+    while (slots_[index].id != EMPTY_ID && slots_[index].id != ERASED_ID) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+} //ctlg
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "memory_usage.h"
+
+namespace ctlg {
+
+// Компактный индекс "имя -> id" с открытой адресацией.
+// В ячейке хранятся старшие биты хеша имени и id, поэтому поиск выполняет
+// один расчёт хеша, а имена сравниваются только при совпадении хешей.
+// Сами имена индекс не хранит: их возвращает функция name_of(id).
+// Строится целиком Build(), точечные правки - Insert() и Erase(); удалённая
+// ячейка остаётся отметкой, пока таблицу не перестроит очередное расширение.
+class FrozenNameIndex {
+public:
+    // entries - пары (имя, id) всех объектов, которые должен находить индекс
+    void Build(const std::vector<std::pair<std::string_view, uint32_t>>& entries);
+    void Clear();
+    bool IsEmpty() const { return slots_.empty(); }
+    // name ещё не должно быть в индексе; name_of нужна, если таблицу придётся расширить
+    template <typename NameOf>
+    void Insert(std::string_view name, uint32_t id, NameOf name_of);
+    // возвращает false, если пары (name, id) в индексе нет
+    bool Erase(std::string_view name, uint32_t id);
+    MemoryUsage GetMemoryUsage() const { return UsageOf(slots_); }
+
+    template <typename NameOf>
+    std::optional<uint32_t> Find(std::string_view name, NameOf name_of) const;
+
+private:
+    static constexpr uint32_t EMPTY_ID = ~uint32_t{0};
+    static constexpr uint32_t ERASED_ID = EMPTY_ID - 1;
+
+    struct Slot {
+        uint32_t tag = 0;
+        uint32_t id = EMPTY_ID;
+    };
+
+    std::vector<Slot> slots_;
+    //занятые ячейки вместе с отметками удаления
+    size_t used_ = 0;
+
+    // первая свободная или удалённая ячейка на пути поиска hash
+    size_t FindFreeSlot(uint64_t hash) const;
+
+    static uint64_t Hash(std::string_view name) {
+        return std::hash<std::string_view>{}(name);
+    }
+    static uint32_t Tag(uint64_t hash) {
+        return static_cast<uint32_t>(hash >> 32);
+    }
+};
+
+template <typename NameOf>
+std::optional<uint32_t> FrozenNameIndex::Find(std::string_view name, NameOf name_of) const {
+    if (slots_.empty()) {
+        return std::nullopt;
+    }
+    const uint64_t hash = Hash(name);
+    const uint32_t tag = Tag(hash);
+    const size_t mask = slots_.size() - 1;
+    for (size_t index = hash & mask; slots_[index].id != EMPTY_ID; index = (index + 1) & mask) {
+        if (slots_[index].tag == tag && slots_[index].id != ERASED_ID && name_of(slots_[index].id) == name) {
+            return slots_[index].id;
+        }
+    }
+    return std::nullopt;
+}
+
+template <typename NameOf>
+void FrozenNameIndex::Insert(std::string_view name, uint32_t id, NameOf name_of) {
+    //заполненность таблицы, как и в Build(), не превышает половины
+    if (slots_.empty() || (used_ + 1) * 2 > slots_.size()) {
+        std::vector<std::pair<std::string_view, uint32_t>> entries;
+        entries.reserve(used_ + 1);
+        for (const Slot& slot : slots_) {
+            if (slot.id != EMPTY_ID && slot.id != ERASED_ID) {
+                entries.push_back({name_of(slot.id), slot.id});
+            }
+        }
+        entries.push_back({name, id});
+        Build(entries);
+        return;
+    }
+    const uint64_t hash = Hash(name);
+    Slot& slot = slots_[FindFreeSlot(hash)];
+    if (slot.id == EMPTY_ID) {
+        ++used_;
+    }
+    slot = {Tag(hash), id};
+}
+
+} //ctlg
@@ -9,7 +9,7 @@ void RequestHandler::AddStop(const Stop& stop) {
     db_.AddStop(std::move(stop));
 }
 
-Stop* RequestHandler::GetStop(string_view stop_name) const {
+const Stop* RequestHandler::GetStop(string_view stop_name) const {
     return db_.GetStop(stop_name);
 }
 
@@ -17,7 +17,19 @@ void RequestHandler::AddBus(const Bus& bus){
     db_.AddBus(std::move(bus));
 }
 
-Bus* RequestHandler::GetBus(string_view bus_name) const{
+bool RequestHandler::RemoveBus(string_view bus_name){
+    return db_.RemoveBus(bus_name);
+}
+
+void RequestHandler::MoveStop(string_view stop_name, geo::Coordinates coord){
+    db_.MoveStop(stop_name, coord);
+}
+
+CatalogueChanges RequestHandler::TakeChanges(){
+    return db_.TakeChanges();
+}
+
+const Bus* RequestHandler::GetBus(string_view bus_name) const{
     return db_.GetBus(bus_name);
 }
 
@@ -25,18 +37,38 @@ void RequestHandler::SetDistance(string_view stop_from_name, string_view stop_to
     db_.SetDistance(stop_from_name, stop_to_name, dist);
 }
 
+void RequestHandler::SetDistance(StopId stop_from, StopId stop_to, int dist) {
+    db_.SetDistance(stop_from, stop_to, dist);
+}
+
 BusStat RequestHandler::GetBusStat(const Bus& bus) const {
     return db_.GetBusStat(bus);
 }
 
+void RequestHandler::UpdateBusStats() {
+    db_.UpdateBusStats();
+}
+
+void RequestHandler::FreezeCatalogue() {
+    db_.Freeze();
+}
+
 StopStat RequestHandler::GetStopStat(const Stop& stop) const {
     return db_.GetStopStat(stop);
 }
 
-vector<std::pair<string_view, Bus *>> RequestHandler::GetRoutes() {
+vector<std::pair<const Stop*, double>> RequestHandler::GetNearestStops(geo::Coordinates point, size_t count) const {
+    return db_.GetNearestStops(point, count);
+}
+
+vector<const Stop*> RequestHandler::GetStopsInArea(geo::Coordinates min, geo::Coordinates max) const {
+    return db_.GetStopsInArea(min, max);
+}
+
+vector<std::pair<string_view, const Bus *>> RequestHandler::GetRoutes() {
     svg::Document svg_doc;
     auto bus_names = db_.GetBuses();
-    vector<std::pair<string_view, Bus *>> routes;
+    vector<std::pair<string_view, const Bus *>> routes;
     for( auto bus_name: bus_names){
         routes.push_back({bus_name, db_.GetBus(bus_name)});
     }
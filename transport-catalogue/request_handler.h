@@ -19,14 +19,22 @@ class RequestHandler {
 public:
 
     RequestHandler(TransportCatalogue& db);
-    vector<std::pair<string_view, Bus *>> GetRoutes();
+    vector<std::pair<string_view, const Bus *>> GetRoutes();
     void AddStop(const Stop& stop);
-	Stop* GetStop(string_view stop_name) const;
+	const Stop* GetStop(string_view stop_name) const;
 	void AddBus(const Bus& bus);
-	Bus* GetBus(string_view bus_name) const;
+    bool RemoveBus(string_view bus_name);
+    void MoveStop(string_view stop_name, geo::Coordinates coord);
+    CatalogueChanges TakeChanges();
+	const Bus* GetBus(string_view bus_name) const;
     void SetDistance(string_view stop_from_name, string_view stop_to_name, int dist);
+    void SetDistance(StopId stop_from, StopId stop_to, int dist);
     BusStat GetBusStat(const Bus& bus) const;
+    void UpdateBusStats();
+    void FreezeCatalogue();
     StopStat GetStopStat(const Stop& stop) const;
+    vector<std::pair<const Stop*, double>> GetNearestStops(geo::Coordinates point, size_t count) const;
+    vector<const Stop*> GetStopsInArea(geo::Coordinates min, geo::Coordinates max) const;
     const TransportCatalogue& GetCatalogue() const { return db_;}
 private:
     TransportCatalogue& db_;
@@ -4,9 +4,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <iterator>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -14,13 +17,76 @@
 
 namespace graph {
 
+// Ограничение на объём работы одного запроса маршрута: по времени и/или
+// по числу вершин, извлечённых поиском из очереди. Проверяется поиском на каждой вершине,
+// часы - на первой и далее периодически.
+class SearchBudget {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    SearchBudget() = default;
+
+    SearchBudget& SetTimeLimit(Clock::duration limit) {
+        deadline_ = Clock::now() + limit;
+        return *this;
+    }
+    SearchBudget& SetMaxVertices(size_t count) {
+        max_vertices_ = count;
+        return *this;
+    }
+
+    // задан ли хотя бы один предел
+    bool IsLimited() const {
+        return deadline_ || max_vertices_;
+    }
+
+    // Учитывает очередную обработанную вершину. Возвращает false, если бюджет исчерпан
+    bool Spend() {
+        if (exhausted_) {
+            return false;
+        }
+        ++vertices_;
+        if (max_vertices_ && vertices_ > *max_vertices_) {
+            exhausted_ = true;
+        } else if (deadline_ && (vertices_ - 1) % CLOCK_CHECK_PERIOD == 0 && Clock::now() >= *deadline_) {
+            exhausted_ = true;
+        }
+        return !exhausted_;
+    }
+
+    bool IsExhausted() const {
+        return exhausted_;
+    }
+
+private:
+    // Часы опрашиваются не на каждой вершине, а раз в CLOCK_CHECK_PERIOD вершин
+    static constexpr size_t CLOCK_CHECK_PERIOD = 64;
+    std::optional<Clock::time_point> deadline_;
+    std::optional<size_t> max_vertices_;
+    size_t vertices_ = 0;
+    bool exhausted_ = false;
+};
+
 template <typename Weight>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
+    // Ячейка таблицы кратчайших путей. Раскладка фиксирована, поэтому таблицу
+    // можно сохранить в файл и подключить из отображённой памяти
+    struct RouteCell {
+        Weight weight;
+        // последнее ребро пути, NO_EDGE для пути из вершины в неё же, NO_ROUTE - пути нет
+        EdgeId prev_edge;
+    };
+    static constexpr EdgeId NO_ROUTE = static_cast<EdgeId>(-1);
+    static constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-2);
+
     explicit Router(const Graph& graph);
+    // Подключает готовую таблицу из graph.GetVertexCount()^2 ячеек, построенную
+    // для того же графа. Таблица не копируется и должна пережить маршрутизатор
+    Router(const Graph& graph, const RouteCell* table);
 
     struct RouteInfo {
         Weight weight;
@@ -28,90 +94,173 @@ public:
     };
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // С неограниченным budget путь берётся из таблицы. С ограниченным - ищется
+    // алгоритмом Дейкстры по графу, и budget тратится на каждую извлечённую из очереди
+    // вершину. При исчерпании budget возвращает nullopt и budget.IsExhausted() == true
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, SearchBudget& budget) const;
+
+    // ячейка (from, to) находится по индексу from * GetVertexCount() + to
+    const RouteCell* GetTable() const {
+        return table_;
+    }
+    size_t GetVertexCount() const {
+        return vertex_count_;
+    }
+    // подключённая извне таблица в отчёт не входит
+    MemoryUsage GetMemoryUsage() const {
+        return UsageOf(own_table_);
+    }
 
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    RouteCell& At(VertexId from, VertexId to) {
+        return own_table_[from * vertex_count_ + to];
+    }
+    const RouteCell& At(VertexId from, VertexId to) const {
+        return table_[from * vertex_count_ + to];
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            At(vertex, vertex) = RouteCell{ZERO_WEIGHT, NO_EDGE};
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                auto& route_internal_data = At(vertex, edge.to);
+                if (route_internal_data.prev_edge == NO_ROUTE || route_internal_data.weight > edge.weight) {
+                    route_internal_data = RouteCell{edge.weight, edge_id};
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
+    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteCell& route_from,
+                    const RouteCell& route_to) {
+        auto& route_relaxing = At(vertex_from, vertex_to);
         const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
+        if (route_relaxing.prev_edge == NO_ROUTE || candidate_weight < route_relaxing.weight) {
             route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+                              route_to.prev_edge != NO_EDGE ? route_to.prev_edge : route_from.prev_edge};
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+    void RelaxRoutesInternalDataThroughVertex(VertexId vertex_through) {
+        for (VertexId vertex_from = 0; vertex_from < vertex_count_; ++vertex_from) {
+            if (const auto& route_from = At(vertex_from, vertex_through); route_from.prev_edge != NO_ROUTE) {
+                for (VertexId vertex_to = 0; vertex_to < vertex_count_; ++vertex_to) {
+                    if (const auto& route_to = At(vertex_through, vertex_to); route_to.prev_edge != NO_ROUTE) {
+                        RelaxRoute(vertex_from, vertex_to, route_from, route_to);
                     }
                 }
             }
         }
     }
 
+    std::optional<RouteInfo> SearchRoute(VertexId from, VertexId to, SearchBudget& budget) const;
+
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    size_t vertex_count_;
+    std::vector<RouteCell> own_table_;
+    const RouteCell* table_;
 };
 
 template <typename Weight>
 Router<Weight>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , vertex_count_(graph.GetVertexCount())
+    , own_table_(vertex_count_ * vertex_count_, RouteCell{ZERO_WEIGHT, NO_ROUTE})
+    , table_(own_table_.data())
 {
     InitializeRoutesInternalData(graph);
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    for (VertexId vertex_through = 0; vertex_through < vertex_count_; ++vertex_through) {
+        RelaxRoutesInternalDataThroughVertex(vertex_through);
     }
 }
 
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, const RouteCell* table)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , table_(table)
+{
+}
+
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    SearchBudget unlimited;
+    return BuildRoute(from, to, unlimited);
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
+                                                                             VertexId to,
+                                                                             SearchBudget& budget) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Router::BuildRoute: vertex is out of range");
+    }
+    if (budget.IsLimited()) {
+        return SearchRoute(from, to, budget);
+    }
+    const auto& route_internal_data = At(from, to);
+    if (route_internal_data.prev_edge == NO_ROUTE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    const Weight weight = route_internal_data.weight;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (EdgeId edge_id = route_internal_data.prev_edge;
+         edge_id != NO_EDGE;
+         edge_id = At(from, graph_.GetEdge(edge_id).from).prev_edge)
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
 
+template <typename Weight>
+std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::SearchRoute(VertexId from,
+                                                                              VertexId to,
+                                                                              SearchBudget& budget) const {
+    using QueueItem = std::pair<Weight, VertexId>;
+    std::vector<RouteCell> cells(vertex_count_, RouteCell{ZERO_WEIGHT, NO_ROUTE});
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    cells[from] = RouteCell{ZERO_WEIGHT, NO_EDGE};
+    queue.push({ZERO_WEIGHT, from});
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        //в очереди могла остаться устаревшая, более длинная запись
+        if (cells[vertex].weight < weight) {
+            continue;
+        }
+        if (!budget.Spend()) {
+            return std::nullopt;
+        }
+        if (vertex == to) {
+            std::vector<EdgeId> edges;
+            for (EdgeId edge_id = cells[to].prev_edge; edge_id != NO_EDGE;
+                 edge_id = cells[graph_.GetEdge(edge_id).from].prev_edge) {
+                edges.push_back(edge_id);
+            }
+            std::reverse(edges.begin(), edges.end());
+            return RouteInfo{weight, std::move(edges)};
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate = weight + edge.weight;
+            RouteCell& cell = cells[edge.to];
+            if (cell.prev_edge == NO_ROUTE || candidate < cell.weight) {
+                cell = RouteCell{candidate, edge_id};
+                queue.push({candidate, edge.to});
+            }
+        }
+    }
+    return std::nullopt;
+}
+
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+#include "spatial_index.h"
+
+namespace geo {
+
+namespace {
+    const double EARTH_RADIUS = 6371000;
+    const double DR = 3.1415926535 / 180.;
+}
+
+void GridIndex::Build(const std::vector<Coordinates>& points) {
+    Clear();
+    if (points.empty()) {
+        return;
+    }
+    points_ = points;
+    auto [lat_min, lat_max] = std::minmax_element(points.begin(), points.end(),
+        [](auto lhs, auto rhs) { return lhs.lat < rhs.lat; });
+    auto [lng_min, lng_max] = std::minmax_element(points.begin(), points.end(),
+        [](auto lhs, auto rhs) { return lhs.lng < rhs.lng; });
+    min_lat_ = lat_min->lat;
+    min_lng_ = lng_min->lng;
+    max_abs_lat_ = std::max(std::abs(lat_min->lat), std::abs(lat_max->lat));
+
+    //в среднем около двух точек на ячейку
+    const size_t side = std::max<size_t>(1, static_cast<size_t>(std::sqrt(points.size() / 2.0)));
+    rows_ = side;
+    cols_ = side;
+    //небольшой запас, чтобы максимальные координаты попадали в последнюю ячейку
+    cell_lat_ = std::max((lat_max->lat - min_lat_) * 1.000001, 1e-9) / rows_;
+    cell_lng_ = std::max((lng_max->lng - min_lng_) * 1.000001, 1e-9) / cols_;
+
+    std::vector<uint32_t> cell_of(points.size());
+    cell_start_.assign(rows_ * cols_ + 1, 0);
+    for (uint32_t id = 0; id < points.size(); ++id) {
+        cell_of[id] = static_cast<uint32_t>(GetRow(points[id].lat) * cols_ + GetCol(points[id].lng));
+        ++cell_start_[cell_of[id] + 1];
+    }
+    for (size_t c = 1; c < cell_start_.size(); ++c) {
+        cell_start_[c] += cell_start_[c - 1];
+    }
+    ids_.resize(points.size());
+    std::vector<uint32_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+    for (uint32_t id = 0; id < points.size(); ++id) {
+        ids_[fill[cell_of[id]]++] = id;
+    }
+}
+
+void GridIndex::Insert(uint32_t id, Coordinates point) {
+    if (points_.empty()) {
+        Build({point});
+        return;
+    }
+    points_.push_back(point);
+    max_abs_lat_ = std::max(max_abs_lat_, std::abs(point.lat));
+    InsertIntoCell(id, GetCell(point));
+}
+
+void GridIndex::Move(uint32_t id, Coordinates point) {
+    const size_t from = GetCell(points_[id]);
+    const size_t to = GetCell(point);
+    points_[id] = point;
+    max_abs_lat_ = std::max(max_abs_lat_, std::abs(point.lat));
+    if (from == to) {
+        return;
+    }
+    const auto begin = ids_.begin() + cell_start_[from];
+    ids_.erase(std::find(begin, ids_.begin() + cell_start_[from + 1], id));
+    for (size_t c = from + 1; c < cell_start_.size(); ++c) {
+        --cell_start_[c];
+    }
+    InsertIntoCell(id, to);
+}
+
+void GridIndex::InsertIntoCell(uint32_t id, size_t cell) {
+    ids_.insert(ids_.begin() + cell_start_[cell + 1], id);
+    for (size_t c = cell + 1; c < cell_start_.size(); ++c) {
+        ++cell_start_[c];
+    }
+}
+
+void GridIndex::Clear() {
+    points_.clear();
+    ids_.clear();
+    cell_start_.clear();
+    rows_ = 0;
+    cols_ = 0;
+}
+
+size_t GridIndex::GetRow(double lat) const {
+    const double row = std::floor((lat - min_lat_) / cell_lat_);
+    return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+}
+
+size_t GridIndex::GetCol(double lng) const {
+    const double col = std::floor((lng - min_lng_) / cell_lng_);
+    return static_cast<size_t>(std::clamp(col, 0.0, static_cast<double>(cols_ - 1)));
+}
+
+std::vector<uint32_t> GridIndex::FindInArea(Coordinates min, Coordinates max) const {
+    std::vector<uint32_t> result;
+    if (points_.empty() || min.lat > max.lat || min.lng > max.lng) {
+        return result;
+    }
+    const size_t row_end = GetRow(max.lat);
+    const size_t col_end = GetCol(max.lng);
+    for (size_t row = GetRow(min.lat); row <= row_end; ++row) {
+        for (size_t col = GetCol(min.lng); col <= col_end; ++col) {
+            const size_t cell = row * cols_ + col;
+            for (uint32_t i = cell_start_[cell]; i < cell_start_[cell + 1]; ++i) {
+                const Coordinates& p = points_[ids_[i]];
+                if (p.lat >= min.lat && p.lat <= max.lat && p.lng >= min.lng && p.lng <= max.lng) {
+                    result.push_back(ids_[i]);
+                }
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// Нижняя оценка расстояния от point до любой точки вне квадрата из колец 0..ring
+// вокруг ячейки (row, col). Стороны квадрата, за которыми ячеек сетки нет, не учитываются.
+double GridIndex::GetRingLowerBound(Coordinates point, size_t row, size_t col, size_t ring) const {
+    double dlat = std::numeric_limits<double>::infinity();
+    double dlng = std::numeric_limits<double>::infinity();
+    if (row >= ring + 1) {
+        dlat = std::min(dlat, point.lat - GetRowLat(row - ring));
+    }
+    if (row + ring + 1 < rows_) {
+        dlat = std::min(dlat, GetRowLat(row + ring + 1) - point.lat);
+    }
+    if (col >= ring + 1) {
+        dlng = std::min(dlng, point.lng - GetColLng(col - ring));
+    }
+    if (col + ring + 1 < cols_) {
+        dlng = std::min(dlng, GetColLng(col + ring + 1) - point.lng);
+    }
+    double bound = std::numeric_limits<double>::infinity();
+    if (dlat != bound) {
+        //вдоль меридиана: расстояние не меньше разности широт
+        bound = std::max(dlat, 0.0) * DR * EARTH_RADIUS;
+    }
+    if (dlng != std::numeric_limits<double>::infinity()) {
+        //hav(d) >= cos^2(max |lat|) * hav(dlng) для точек с |lat| <= max |lat|
+        const double max_lat = std::max(max_abs_lat_, std::abs(point.lat)) * DR;
+        const double half = std::min(std::max(dlng, 0.0) * DR / 2, 3.1415926535 / 2);
+        bound = std::min(bound, 2 * EARTH_RADIUS * std::asin(std::min(1.0, std::cos(max_lat) * std::sin(half))));
+    }
+    return bound;
+}
+
+std::vector<std::pair<uint32_t, double>> GridIndex::FindNearest(Coordinates point, size_t count) const {
+    std::vector<std::pair<uint32_t, double>> result;
+    if (points_.empty() || count == 0) {
+        return result;
+    }
+    auto farther = [](const auto& lhs, const auto& rhs) {
+        return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+    };
+    //на вершине - самый дальний из найденных кандидатов
+    std::priority_queue<std::pair<uint32_t, double>, std::vector<std::pair<uint32_t, double>>, decltype(farther)> best(farther);
+    const size_t row = GetRow(point.lat);
+    const size_t col = GetCol(point.lng);
+    const size_t max_ring = std::max(rows_, cols_);
+    for (size_t ring = 0; ring <= max_ring; ++ring) {
+        const size_t r_begin = row >= ring ? row - ring : 0;
+        const size_t r_end = std::min(rows_ - 1, row + ring);
+        const size_t c_begin = col >= ring ? col - ring : 0;
+        const size_t c_end = std::min(cols_ - 1, col + ring);
+        for (size_t r = r_begin; r <= r_end; ++r) {
+            for (size_t c = c_begin; c <= c_end; ++c) {
+                //только ячейки на границе текущего кольца
+                if (r + ring != row && r != row + ring && c + ring != col && c != col + ring) {
+                    continue;
+                }
+                const size_t cell = r * cols_ + c;
+                for (uint32_t i = cell_start_[cell]; i < cell_start_[cell + 1]; ++i) {
+                    std::pair<uint32_t, double> candidate{ids_[i], ComputeDistance(point, points_[ids_[i]])};
+                    if (best.size() < count) {
+                        best.push(candidate);
+                    } else if (farther(candidate, best.top())) {
+                        best.pop();
+                        best.push(candidate);
+                    }
+                }
+            }
+        }
+        if (best.size() == count && GetRingLowerBound(point, row, col, ring) > best.top().second) {
+            break;
+        }
+    }
+    while (!best.empty()) {
+        result.push_back(best.top());
+        best.pop();
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+} //geo
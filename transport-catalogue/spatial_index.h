@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "geo.h"
+#include "memory_usage.h"
+
+namespace geo {
+
+// Равномерная сетка по широте и долготе над набором точек.
+// Точки каждой ячейки хранятся подряд в общем массиве ids_,
+// ячейка c занимает диапазон [cell_start_[c], cell_start_[c + 1]).
+// Границы сетки задаёт Build(); точка, добавленная или перенесённая за них,
+// попадает в крайнюю ячейку, и поиск остаётся точным.
+class GridIndex {
+public:
+    // points[id] - координаты точки с идентификатором id
+    void Build(const std::vector<Coordinates>& points);
+    void Clear();
+    bool IsEmpty() const { return points_.empty(); }
+    // id должен быть равен числу уже добавленных точек
+    void Insert(uint32_t id, Coordinates point);
+    void Move(uint32_t id, Coordinates point);
+    MemoryUsage GetMemoryUsage() const {
+        return UsageOf(points_) + UsageOf(ids_) + UsageOf(cell_start_);
+    }
+
+    // Идентификаторы точек внутри прямоугольника, включая границы, по возрастанию id
+    std::vector<uint32_t> FindInArea(Coordinates min, Coordinates max) const;
+    // До count ближайших к point точек с расстояниями в метрах, по возрастанию расстояния
+    std::vector<std::pair<uint32_t, double>> FindNearest(Coordinates point, size_t count) const;
+
+private:
+    std::vector<Coordinates> points_;
+    std::vector<uint32_t> ids_;
+    std::vector<uint32_t> cell_start_;
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    double min_lat_ = 0;
+    double min_lng_ = 0;
+    double cell_lat_ = 1;
+    double cell_lng_ = 1;
+    double max_abs_lat_ = 0;
+
+    size_t GetRow(double lat) const;
+    size_t GetCol(double lng) const;
+    size_t GetCell(Coordinates point) const { return GetRow(point.lat) * cols_ + GetCol(point.lng); }
+    // вставка id в конец ячейки cell со сдвигом следующих ячеек
+    void InsertIntoCell(uint32_t id, size_t cell);
+    double GetRowLat(size_t row) const { return min_lat_ + row * cell_lat_; }
+    double GetColLng(size_t col) const { return min_lng_ + col * cell_lng_; }
+    double GetRingLowerBound(Coordinates point, size_t row, size_t col, size_t ring) const;
+};
+
+} //geo
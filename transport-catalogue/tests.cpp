@@ -1,8 +1,25 @@
 #include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
 #include <fstream>
+#include <future>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "catalogue_image.h"
+#include "catalogue_snapshot.h"
+#include "distance_table.h"
+#include "json_compact.h"
+#include "json_parallel.h"
+#include "json_schema.h"
+#include "json_writer.h"
+#include "name_index.h"
+#include "spatial_index.h"
 #include "map_renderer.h"
 #include "json_reader.h"
 #include "request_handler.h"
@@ -82,7 +99,7 @@ void TestRenderRoutes(){
         jreader.ApplyCommands();
         MapRenderer rend{jreader.GetRendererSettings()};
         auto routes = handler.GetRoutes();
-        rend.SetRoutes(routes);
+        rend.SetRoutes(routes, catalogue.GetAllStops());
         svg::Document doc = rend.RenderMap();
         std::ofstream out{"out/myout.svg"};
         // doc.Render(out);
@@ -135,10 +152,834 @@ void TestGraphBuilding1(){
 }
 
 
+// Небольшой справочник: некольцевой автобус 1 A-B-C и кольцевой 2 C-D-A-C.
+// ab_distance позволяет получить справочник той же формы с другими расстояниями
+string MakeTestInput(int ab_distance = 1000, string_view stat_requests = "[]"sv){
+    std::ostringstream out;
+    out << R"({"base_requests": [
+        {"type": "Stop", "name": "A", "latitude": 55.60, "longitude": 37.20, "road_distances": {"B": )"sv
+        << ab_distance << R"(}},
+        {"type": "Stop", "name": "B", "latitude": 55.61, "longitude": 37.21, "road_distances": {"C": 1500}},
+        {"type": "Stop", "name": "C", "latitude": 55.62, "longitude": 37.22, "road_distances": {"D": 2000}},
+        {"type": "Stop", "name": "D", "latitude": 55.63, "longitude": 37.20, "road_distances": {"A": 2500}},
+        {"type": "Bus", "name": "1", "stops": ["A", "B", "C"], "is_roundtrip": false},
+        {"type": "Bus", "name": "2", "stops": ["C", "D", "A", "C"], "is_roundtrip": true}
+    ],
+    "routing_settings": {"bus_wait_time": 2, "bus_velocity": 30},
+    "render_settings": {"width": 600, "height": 400, "padding": 50, "stop_radius": 5, "line_width": 14,
+        "bus_label_font_size": 20, "bus_label_offset": [7, 15], "stop_label_font_size": 18,
+        "stop_label_offset": [7, -3], "underlayer_color": [255, 255, 255, 0.85], "underlayer_width": 3,
+        "color_palette": ["green", [255, 160, 0], "red"]},
+    "stat_requests": )"sv << stat_requests << "}"sv;
+    return out.str();
+}
+
+//ответы на stat_requests входа input, разобранного в режиме mode, в компактном виде
+string GetTestStats(const string& input, ctlg::jreader::InputMode mode){
+    TransportCatalogue catalogue;
+    RequestHandler handler{catalogue};
+    ctlg::jreader::JsonReader jreader(handler, string_view{input}, mode);
+    jreader.ApplyCommands();
+    return jreader.GetStats(json::PrintStyle::COMPACT);
+}
+
+void TestSearchBudget(){
+    //цепочка 0 -> 1 -> ... -> 9 и короткий путь 0 -> 9 через вершину 10
+    graph::DirectedWeightedGraph<double> graph(11);
+    for(graph::VertexId v = 0; v < 9; ++v){
+        graph.AddEdge({v, v + 1, "chain"sv, 1, 1.0});
+    }
+    graph.AddEdge({0, 10, "short"sv, 1, 2.0});
+    graph.AddEdge({10, 9, "short"sv, 1, 2.5});
+    graph::Router<double> router(graph);
+
+    //поиск по графу совпадает с таблицей
+    for(graph::VertexId from = 0; from < 11; ++from){
+        for(graph::VertexId to = 0; to < 11; ++to){
+            const auto by_table = router.BuildRoute(from, to);
+            graph::SearchBudget budget;
+            budget.SetMaxVertices(100);
+            const auto by_search = router.BuildRoute(from, to, budget);
+            assert(!budget.IsExhausted());
+            assert(by_table.has_value() == by_search.has_value());
+            if(by_table){
+                assert(std::abs(by_table->weight - by_search->weight) < 1e-9);
+                assert(by_table->edges.size() == by_search->edges.size());
+            }
+        }
+    }
+    const auto route = router.BuildRoute(0, 9);
+    assert(route && route->weight == 4.5 && route->edges.size() == 2);
+
+    graph::SearchBudget small;
+    small.SetMaxVertices(2);
+    assert(!router.BuildRoute(0, 9, small));
+    assert(small.IsExhausted());
+
+    graph::SearchBudget timed;
+    timed.SetTimeLimit(std::chrono::hours(1));
+    assert(timed.IsLimited());
+    assert(router.BuildRoute(0, 9, timed) && !timed.IsExhausted());
+
+    //исчерпанный бюджет в ответе - timeout, ошибка маршрута - not found
+    const string input = MakeTestInput(1000, R"([
+        {"id": 1, "type": "Route", "from": "A", "to": "C", "max_vertices": 1},
+        {"id": 2, "type": "Route", "from": "A", "to": "C", "max_vertices": 1000},
+        {"id": 3, "type": "Route", "from": "A", "to": "C"}])"sv);
+    const json::Array answers = json::Load(GetTestStats(input, ctlg::jreader::InputMode::DOCUMENT)).GetRoot().AsArray();
+    assert(answers[0].AsDict().at("error_message"s).AsString() == "timeout"s);
+    assert(answers[1].AsDict().at("total_time"s) == answers[2].AsDict().at("total_time"s));
+}
+
+void TestDistanceTable(){
+    DistanceTable table;
+    assert(!table.Get(0, 1));
+    table.Set(0, 1, 100);
+    //обратное направление берётся из прямого, пока не задано явно
+    assert(table.Get(0, 1) == 100);
+    assert(table.Get(1, 0) == 100);
+    table.Set(1, 0, 70);
+    assert(table.Get(0, 1) == 100);
+    assert(table.Get(1, 0) == 70);
+    table.Set(0, 1, 120);
+    assert(table.Get(0, 1) == 120);
+    assert(table.Get(1, 0) == 70);
+
+    //расширение таблицы сохраняет все записи
+    for(StopId i = 2; i < 1000; ++i){
+        table.Set(i, i + 1, static_cast<int>(i));
+    }
+    for(StopId i = 2; i < 1000; ++i){
+        assert(table.Get(i, i + 1) == static_cast<int>(i));
+        assert(table.Get(i + 1, i) == static_cast<int>(i));
+    }
+    assert(!table.Get(5, 7));
+    size_t explicit_count = 0;
+    table.ForEachExplicit([&explicit_count](StopId, StopId, int){ ++explicit_count; });
+    assert(explicit_count == 2 + 998);
+}
+
+void TestNameIndex(){
+    vector<string> names;
+    for(int i = 0; i < 100; ++i){
+        names.push_back("Stop "s + std::to_string(i));
+    }
+    auto name_of = [&names](uint32_t id) -> string_view { return names[id]; };
+
+    FrozenNameIndex index;
+    assert(index.IsEmpty());
+    assert(!index.Find("Stop 0"sv, name_of));
+    vector<std::pair<string_view, uint32_t>> entries;
+    for(uint32_t id = 0; id < names.size(); ++id){
+        entries.push_back({names[id], id});
+    }
+    index.Build(entries);
+    for(uint32_t id = 0; id < names.size(); ++id){
+        assert(index.Find(names[id], name_of) == id);
+    }
+    assert(!index.Find("Stop 100"sv, name_of));
+    assert(!index.Find(""sv, name_of));
+
+    index.Clear();
+    assert(index.IsEmpty());
+    assert(!index.Find("Stop 1"sv, name_of));
+}
+
+//результат сетки сверяется с полным перебором points
+void CheckGridSearch(const geo::GridIndex& grid, const vector<geo::Coordinates>& points,
+                     geo::Coordinates min, geo::Coordinates max, geo::Coordinates center){
+    vector<uint32_t> expected_area;
+    for(uint32_t id = 0; id < points.size(); ++id){
+        if(points[id].lat >= min.lat && points[id].lat <= max.lat
+           && points[id].lng >= min.lng && points[id].lng <= max.lng){
+            expected_area.push_back(id);
+        }
+    }
+    assert(grid.FindInArea(min, max) == expected_area);
+
+    vector<double> distances;
+    for(const geo::Coordinates& point : points){
+        distances.push_back(geo::ComputeDistance(center, point));
+    }
+    std::sort(distances.begin(), distances.end());
+    const auto nearest = grid.FindNearest(center, 5);
+    assert(nearest.size() == 5);
+    for(size_t i = 0; i < nearest.size(); ++i){
+        assert(std::abs(nearest[i].second - distances[i]) < 1e-6);
+        assert(std::abs(geo::ComputeDistance(center, points[nearest[i].first]) - nearest[i].second) < 1e-6);
+    }
+}
+
+//сетка 20x20 слегка скошенных точек
+vector<geo::Coordinates> MakeGridPoints(){
+    vector<geo::Coordinates> points;
+    for(int i = 0; i < 20; ++i){
+        for(int j = 0; j < 20; ++j){
+            points.push_back({55.5 + i * 0.01 + j * 0.0003, 37.5 + j * 0.01 + i * 0.0007});
+        }
+    }
+    return points;
+}
+
+void TestSpatialGrid(){
+    const vector<geo::Coordinates> points = MakeGridPoints();
+    geo::GridIndex grid;
+    assert(grid.IsEmpty());
+    grid.Build(points);
+    CheckGridSearch(grid, points, {55.55, 37.55}, {55.6, 37.62}, {55.57, 37.58});
+    CheckGridSearch(grid, points, {55.0, 37.0}, {56.0, 38.0}, {55.4, 37.4});
+    //центр поиска вне сетки
+    CheckGridSearch(grid, points, {54.0, 36.0}, {54.1, 36.1}, {54.0, 36.0});
+    assert(grid.FindNearest({55.5, 37.5}, 1000).size() == points.size());
+}
+
+void TestMapViewport(){
+    const string input = MakeTestInput();
+    auto catalogue = std::make_unique<TransportCatalogue>();
+    RequestHandler handler{*catalogue};
+    ctlg::jreader::JsonReader jreader(handler, string_view{input});
+    jreader.ApplyCommands();
+    const CatalogueSnapshot snapshot(std::move(catalogue), jreader.GetRoutingSettings(),
+                                     jreader.GetRendererSettings());
+    assert(!snapshot.GetRenderedMap());
+    const string& map = snapshot.GetMap();
+    assert(snapshot.GetRenderedMap() == &map);
+
+    //область со всеми остановками даёт всю карту, пустая - карту без остановок
+    assert(snapshot.RenderMap({55.0, 37.0}, {56.0, 38.0}) == map);
+    const string empty = snapshot.RenderMap({10.0, 10.0}, {10.1, 10.1});
+    assert(empty.size() < map.size());
+    assert(empty.find("<circle"sv) == string::npos);
+    const string part = snapshot.RenderMap({55.595, 37.195}, {55.605, 37.205});
+    assert(part.size() > empty.size() && part.size() < map.size());
+    assert(part.find(">A<"sv) != string::npos && part.find(">D<"sv) == string::npos);
+
+    //запрос Map с viewport отвечает так же
+    const string map_requests = R"([{"id": 1, "type": "Map", "viewport":
+        {"min_latitude": 55.595, "min_longitude": 37.195, "max_latitude": 55.605, "max_longitude": 37.205}}])"s;
+    const string stats = GetTestStats(MakeTestInput(1000, map_requests), ctlg::jreader::InputMode::DOCUMENT);
+    assert(json::Load(stats).GetRoot().AsArray()[0].AsDict().at("map"s).AsString() == part);
+}
+
+void TestRouteIterator(){
+    const Bus plain{"1"sv, {0, 1, 2}, false};
+    const vector<StopId> plain_route(plain.GetRoute().begin(), plain.GetRoute().end());
+    assert((plain_route == vector<StopId>{0, 1, 2, 1, 0}));
+    assert(plain.GetRouteStopCount() == 5);
+
+    const Bus round{"2"sv, {2, 3, 0, 2}, true};
+    const vector<StopId> round_route(round.GetRoute().begin(), round.GetRoute().end());
+    assert((round_route == vector<StopId>{2, 3, 0, 2}));
+}
+
+void TestNameIndexUpdates(){
+    vector<string> names;
+    for(int i = 0; i < 100; ++i){
+        names.push_back("Stop "s + std::to_string(i));
+    }
+    auto name_of = [&names](uint32_t id) -> string_view { return names[id]; };
+
+    FrozenNameIndex index;
+    vector<std::pair<string_view, uint32_t>> entries;
+    for(uint32_t id = 0; id < 10; ++id){
+        entries.push_back({names[id], id});
+    }
+    index.Build(entries);
+    //вставки с расширением таблицы
+    for(uint32_t id = 10; id < 100; ++id){
+        index.Insert(names[id], id, name_of);
+    }
+    for(uint32_t id = 0; id < 100; ++id){
+        assert(index.Find(names[id], name_of) == id);
+    }
+
+    assert(index.Erase("Stop 5"sv, 5));
+    assert(!index.Erase("Stop 5"sv, 5));
+    assert(!index.Erase("Stop 6"sv, 7));
+    assert(!index.Find("Stop 5"sv, name_of));
+    //поиск проходит через удалённую ячейку
+    for(uint32_t id = 0; id < 100; ++id){
+        assert(id == 5 || index.Find(names[id], name_of) == id);
+    }
+    index.Insert(names[5], 5, name_of);
+    assert(index.Find("Stop 5"sv, name_of) == 5u);
+
+    //вставка в пустой индекс
+    FrozenNameIndex empty;
+    empty.Insert(names[0], 0, name_of);
+    assert(empty.Find(names[0], name_of) == 0u);
+}
+
+void TestSpatialGridUpdates(){
+    vector<geo::Coordinates> points = MakeGridPoints();
+    geo::GridIndex grid;
+    grid.Build(points);
+
+    //точка за границами сетки попадает в крайнюю ячейку
+    points.push_back({56.0, 38.0});
+    grid.Insert(static_cast<uint32_t>(points.size() - 1), points.back());
+    points[0] = {55.61, 37.61};
+    grid.Move(0, points[0]);
+    CheckGridSearch(grid, points, {55.55, 37.55}, {55.62, 37.62}, {55.61, 37.61});
+    CheckGridSearch(grid, points, {55.9, 37.9}, {56.1, 38.1}, {56.0, 38.0});
+    assert(grid.FindNearest({56.0, 38.0}, 1).front().first == points.size() - 1);
+}
+
+void TestIncrementalIndexes(){
+    const string input = MakeTestInput();
+    TransportCatalogue catalogue;
+    RequestHandler handler{catalogue};
+    ctlg::jreader::JsonReader jreader(handler, string_view{input});
+    jreader.ApplyCommands();
+    assert(catalogue.IsFrozen());
+
+    //остановка, добавленная после заморозки, находится по имени и по координатам
+    catalogue.AddStop(Stop{"E"sv, {55.70, 37.30}});
+    const Stop* e = catalogue.GetStop("E"sv);
+    assert(e && e->name_ == "E"sv);
+    assert(catalogue.GetNearestStops({55.71, 37.31}, 1).front().first == e);
+    auto in_area = catalogue.GetStopsInArea({55.69, 37.29}, {55.71, 37.31});
+    assert(in_area.size() == 1 && in_area.front() == e);
+
+    catalogue.MoveStop("A"sv, {55.70, 37.31});
+    in_area = catalogue.GetStopsInArea({55.69, 37.29}, {55.71, 37.32});
+    assert(in_area.size() == 2);
+    assert(catalogue.GetStopsInArea({55.599, 37.199}, {55.601, 37.201}).empty());
+
+    catalogue.SetDistance("C"sv, "E"sv, 800);
+    catalogue.AddBus(Bus{"3"sv, {catalogue.GetStop("C"sv)->id_, e->id_}, false});
+    assert(catalogue.GetBus("3"sv) && catalogue.GetBus("3"sv)->name_ == "3"sv);
+    assert((catalogue.GetStopBuses("E"sv) == vector<string_view>{"3"sv}));
+    assert((catalogue.GetStopBuses("C"sv) == vector<string_view>{"1"sv, "2"sv, "3"sv}));
+
+    assert(catalogue.RemoveBus("1"sv));
+    assert(!catalogue.RemoveBus("1"sv));
+    assert(!catalogue.GetBus("1"sv));
+    assert((catalogue.GetStopBuses("B"sv) == vector<string_view>{}));
+    assert((catalogue.GetBuses() == vector<string_view>{"2"sv, "3"sv}));
+    const CatalogueChanges changes = catalogue.TakeChanges();
+    assert(changes.routes && changes.map);
+    assert(!catalogue.TakeChanges().routes);
+}
+
+//справочник MakeTestInput(ab_distance) после ApplyCommands
+std::unique_ptr<TransportCatalogue> LoadTestCatalogue(int ab_distance, RoutingSettings& rs){
+    auto catalogue = std::make_unique<TransportCatalogue>();
+    RequestHandler handler{*catalogue};
+    const string input = MakeTestInput(ab_distance);
+    ctlg::jreader::JsonReader jreader(handler, string_view{input});
+    jreader.ApplyCommands();
+    rs = jreader.GetRoutingSettings();
+    return catalogue;
+}
+
+void TestCatalogueImage(){
+    RoutingSettings rs;
+    const auto catalogue = LoadTestCatalogue(1000, rs);
+    const string path = "test_catalogue.img"s;
+    {
+        std::ofstream out(path, std::ios::binary);
+        CatalogueImage::Save(*catalogue, out);
+    }
+    {
+        std::unique_ptr<TransportCatalogue> loaded = CatalogueImage::Load(path);
+        loaded->UpdateBusStats();
+        loaded->Freeze();
+        assert(loaded->GetAllStops().size() == catalogue->GetAllStops().size());
+        for(const Stop& stop : catalogue->GetAllStops()){
+            const Stop* copy = loaded->GetStop(stop.name_);
+            assert(copy && copy->id_ == stop.id_);
+            assert(copy->coord_ == stop.coord_);
+            assert(loaded->GetStopBuses(stop.name_) == catalogue->GetStopBuses(stop.name_));
+        }
+        for(auto [from, to] : {std::pair{"A"sv, "B"sv}, {"B"sv, "A"sv}, {"C"sv, "D"sv}, {"D"sv, "A"sv}}){
+            assert(loaded->GetDistance(loaded->GetStop(from), loaded->GetStop(to))
+                   == catalogue->GetDistance(catalogue->GetStop(from), catalogue->GetStop(to)));
+        }
+        assert(loaded->GetBuses() == catalogue->GetBuses());
+        for(string_view name : catalogue->GetBuses()){
+            const BusStat expected = catalogue->GetBusStat(*catalogue->GetBus(name));
+            const BusStat actual = loaded->GetBusStat(*loaded->GetBus(name));
+            assert(actual.stops == expected.stops && actual.unique_stops == expected.unique_stops);
+            assert(actual.lenght == expected.lenght && actual.lenght_geo == expected.lenght_geo);
+        }
+    }
+
+    //испорченный образ не загружается
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('\x7f');
+    }
+    bool thrown = false;
+    try{
+        CatalogueImage::Load(path);
+    } catch(const std::runtime_error&){
+        thrown = true;
+    }
+    assert(thrown);
+    std::remove(path.c_str());
+}
+
+void TestRoutesAttach(){
+    RoutingSettings rs;
+    const auto catalogue = LoadTestCatalogue(1000, rs);
+    const string path = "test_routes.bin"s;
+    transport_router built{*catalogue, rs};
+    built.CreateAllData();
+    built.SaveRoutes(path);
+
+    //подключённая таблица даёт те же маршруты
+    transport_router attached{*catalogue, rs};
+    attached.AttachRoutes(path);
+    for(const Stop& from : catalogue->GetAllStops()){
+        for(const Stop& to : catalogue->GetAllStops()){
+            const auto expected = built.CreateRoute(from.name_, to.name_);
+            const auto actual = attached.CreateRoute(from.name_, to.name_);
+            assert(expected.has_value() == actual.has_value());
+            assert(!expected || expected->total_time == actual->total_time);
+        }
+    }
+
+    //таблица справочника той же формы, но с другими расстояниями, не подходит
+    RoutingSettings other_rs;
+    const auto other = LoadTestCatalogue(7000, other_rs);
+    auto expect_rejected = [&path](const TransportCatalogue& db, RoutingSettings settings){
+        transport_router router{db, settings};
+        bool thrown = false;
+        try{
+            router.AttachRoutes(path);
+        } catch(const std::runtime_error&){
+            thrown = true;
+        }
+        assert(thrown);
+    };
+    expect_rejected(*other, other_rs);
+    expect_rejected(*catalogue, RoutingSettings{rs.bus_wait_time + 1, rs.bus_velocity});
+
+    //испорченная таблица не подключается
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('\x7f');
+    }
+    expect_rejected(*catalogue, rs);
+    std::remove(path.c_str());
+}
+
+void TestJsonNumbers(){
+    auto root = [](string_view text){ return json::Load(text).GetRoot(); };
+    assert(root("0"sv).IsInt() && root("0"sv).AsInt() == 0);
+    assert(root("-0"sv).IsInt() && root("-0"sv).AsInt() == 0);
+    assert(root("2147483647"sv).AsInt() == 2147483647);
+    assert(root("-2147483648"sv).AsInt() == -2147483647 - 1);
+    //целое вне int становится double
+    assert(root("2147483648"sv).IsPureDouble() && root("2147483648"sv).AsDouble() == 2147483648.0);
+    assert(root("1e3"sv).IsPureDouble() && root("1e3"sv).AsDouble() == 1000.0);
+    assert(root("1.5E-2"sv).AsDouble() == 0.015);
+    assert(root("-0.25"sv).AsDouble() == -0.25);
+    for(string_view bad : {"-"sv, "1."sv, ".5"sv, "1e"sv, "+1"sv}){
+        bool thrown = false;
+        try{
+            json::Load(bad);
+        } catch(const json::ParsingError&){
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+}
+
+void TestJsonEscapes(){
+    const string text = R"({"name": "a\"b\\c\nd\re\tf", "list": ["\"", "\\"]})";
+    const json::Document doc = json::Load(string_view{text});
+    assert(doc.GetRoot().AsDict().at("name"s).AsString() == "a\"b\\c\nd\re\tf"s);
+
+    const json::compact::Document compact = json::compact::Load(string_view{text});
+    assert(compact.GetRoot().AsDict().at("name"sv).AsString() == "a\"b\\c\nd\re\tf"sv);
+    assert(compact.GetRoot().ToNode() == doc.GetRoot());
+
+    //раскодированная строка не зависит от буфера разбора
+    const string long_text = "[\""s + string(1000, 'x') + "\\n\"]"s;
+    const json::compact::Document long_doc = json::compact::Load(string_view{long_text});
+    assert(long_doc.GetRoot().AsArray()[0].AsString() == string(1000, 'x') + "\n"s);
+
+    bool thrown = false;
+    try{
+        json::Load(R"(["\q"])"sv);
+    } catch(const json::ParsingError&){
+        thrown = true;
+    }
+    assert(thrown);
+
+    //имена с экранированием одинаковы во всех режимах разбора
+    const string input = MakeTestInput(1000, R"([{"id": 1, "type": "Stop", "name": "A"}])"sv);
+    string escaped = input;
+    for(size_t pos = escaped.find("\"A\""s); pos != string::npos; pos = escaped.find("\"A\""s, pos + 1)){
+        escaped.replace(pos, 3, R"("A\"q\\")"s);
+    }
+    const string document = GetTestStats(escaped, ctlg::jreader::InputMode::DOCUMENT);
+    assert(document == GetTestStats(escaped, ctlg::jreader::InputMode::STREAM));
+    assert(document == GetTestStats(escaped, ctlg::jreader::InputMode::PARALLEL));
+    assert(document == GetTestStats(input, ctlg::jreader::InputMode::DOCUMENT));
+}
+
+void TestDuplicateKeys(){
+    auto expect_error = [](auto load){
+        bool thrown = false;
+        try{
+            load();
+        } catch(const json::ParsingError& e){
+            thrown = string_view{e.what()}.find("Duplicate key 'a'"sv) != string_view::npos;
+        }
+        assert(thrown);
+    };
+    const string text = R"({"b": 1, "a": 2, "a": 3})";
+    expect_error([&text]{ json::Load(string_view{text}); });
+    expect_error([&text]{ json::compact::Load(string_view{text}); });
+    expect_error([]{ json::Load(R"([{"x": {"a": 1, "a": 2}}])"sv); });
+    //одинаковые ключи в разных словарях допустимы
+    json::Load(R"([{"a": 1}, {"a": 2}])"sv);
+
+    const string input = MakeTestInput();
+    string duplicated = input;
+    duplicated.replace(duplicated.find(R"("name": "A")"s), 11, R"("name": "A", "a": 1, "a": 2)"s);
+    for(auto mode : {ctlg::jreader::InputMode::DOCUMENT, ctlg::jreader::InputMode::STREAM,
+                     ctlg::jreader::InputMode::PARALLEL}){
+        expect_error([&duplicated, mode]{ GetTestStats(duplicated, mode); });
+    }
+}
+
+void TestUnsignedDecode(){
+    using json::schema::Decode;
+    assert(Decode<size_t>(json::Node{5}) == 5u);
+    assert(Decode<uint32_t>(json::Node{0}) == 0u);
+    for(int value : {-1, -2147483647 - 1}){
+        bool thrown = false;
+        try{
+            Decode<size_t>(json::Node{value});
+        } catch(const std::out_of_range&){
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    const string input = MakeTestInput(1000,
+        R"([{"id": 1, "type": "NearestStops", "latitude": 55.6, "longitude": 37.2, "count": -1}])"sv);
+    bool thrown = false;
+    try{
+        GetTestStats(input, ctlg::jreader::InputMode::DOCUMENT);
+    } catch(const std::out_of_range&){
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void TestLoadRootArray(){
+    string text = R"({"render_settings": {}, "base_requests": [)";
+    for(int i = 0; i < 100; ++i){
+        text += (i ? ", "s : ""s) + R"({"id": )"s + std::to_string(i) + R"(, "s": "x,]\"y"})"s;
+    }
+    text += R"(], "stat_requests": []})";
+
+    for(size_t chunk_count : {1u, 3u, 7u, 200u}){
+        const auto chunks = json::compact::LoadRootArray(text, "base_requests"sv, chunk_count);
+        assert(chunks);
+        assert(chunks->GetText().front() == '[' && chunks->GetText().back() == ']');
+        assert(chunks->GetChunks().size() <= chunk_count);
+        //части идут по порядку и вместе дают весь массив
+        int next_id = 0;
+        for(const json::compact::Document& chunk : chunks->GetChunks()){
+            for(json::compact::Node node : chunk.GetRoot().AsArray()){
+                assert(node.AsDict().at("id"sv).AsInt() == next_id++);
+                assert(node.AsDict().at("s"sv).AsString() == "x,]\"y"sv);
+            }
+        }
+        assert(next_id == 100);
+    }
+    assert(!json::compact::LoadRootArray(text, "missing"sv, 2));
+    assert(!json::compact::LoadRootArray(text, "render_settings"sv, 2));
+    assert(!json::compact::LoadRootArray("[1, 2]"sv, "base_requests"sv, 2));
+}
+
+//ответ из разных типов значений, вложенных и пустых контейнеров
+json::Array MakeTestAnswers(){
+    const json::Node answer = json::Builder{}.StartDict()
+        .Key("request_id"s).Value(1)
+        .Key("items"s).StartArray().Value("a\"\n\\"s).Value(2.5).Value(-7).EndArray()
+        .Key("empty"s).StartArray().EndArray()
+        .Key("empty_dict"s).StartDict().EndDict()
+        .EndDict().Build();
+    return json::Array{answer, json::Node{nullptr}, json::Node{true}};
+}
+
+void TestWriter(){
+    const json::Node answers{MakeTestAnswers()};
+    for(auto style : {json::PrintStyle::PRETTY, json::PrintStyle::COMPACT}){
+        json::Writer writer(style);
+        writer.Write(answers);
+        const string text = writer.TakeBuffer();
+        assert(writer.TakeBuffer().empty());
+        assert(json::Load(text).GetRoot() == answers);
+
+        std::ostringstream printed;
+        json::Print(json::Document{answers}, printed, style);
+        assert(printed.str() == text);
+    }
+    json::Writer compact(json::PrintStyle::COMPACT);
+    compact.Write(json::Node{json::Array{json::Node{1}, json::Node{"x"s}}});
+    assert(compact.TakeBuffer() == R"([1,"x"])"s);
+
+    //double выводится кратчайшей записью, которая читается обратно без потерь
+    for(double value : {0.1, 1.0 / 3, 43.587795, 1e-300, -2147483648.0}){
+        json::Writer writer(json::PrintStyle::COMPACT);
+        writer.Write(json::Node{value});
+        assert(json::Load(writer.TakeBuffer()).GetRoot().AsDouble() == value);
+    }
+}
+
+void TestStreamingWriter(){
+    const json::Array answers = MakeTestAnswers();
+
+    //ответы по одному дают тот же текст, что и печать массива целиком
+    for(auto style : {json::PrintStyle::PRETTY, json::PrintStyle::COMPACT}){
+        std::ostringstream expected;
+        json::Print(json::Document{json::Node{answers}}, expected, style);
+
+        json::Writer writer(style);
+        writer.StartArray();
+        for(const json::Node& node : answers){
+            writer.Write(node);
+        }
+        writer.EndArray();
+        assert(writer.TakeBuffer() == expected.str());
+
+        std::ostringstream streamed;
+        {
+            json::Writer stream_writer(streamed, style);
+            stream_writer.StartArray();
+            for(const json::Node& node : answers){
+                stream_writer.Write(node);
+            }
+            stream_writer.EndArray();
+        }
+        assert(streamed.str() == expected.str());
+    }
+
+    json::Writer empty(json::PrintStyle::COMPACT);
+    empty.StartArray();
+    empty.EndArray();
+    assert(empty.TakeBuffer() == "[]"s);
+
+    //ответ больше блока уходит в поток частями, текст не меняется
+    std::ostringstream big;
+    const json::Node long_string{string(json::Writer::FLUSH_SIZE * 3, 'x')};
+    {
+        json::Writer writer(big, json::PrintStyle::COMPACT);
+        writer.StartArray();
+        writer.Write(long_string);
+        writer.Write(json::Node{1});
+        writer.EndArray();
+    }
+    assert(big.str() == "[\""s + long_string.AsString() + "\",1]"s);
+}
+
+void TestStatsWithBadRequest(){
+    //ошибка в запросе обнаруживается до вывода первого ответа
+    const string input = MakeTestInput(1000,
+        R"([{"id": 1, "type": "Bus", "name": "1"}, {"id": 2, "type": "Route", "from": "A"}])"sv);
+    TransportCatalogue catalogue;
+    RequestHandler handler{catalogue};
+    ctlg::jreader::JsonReader jreader(handler, string_view{input});
+    jreader.ApplyCommands();
+    std::ostringstream out;
+    bool thrown = false;
+    try{
+        jreader.WriteStats(out);
+    } catch(const std::exception&){
+        thrown = true;
+    }
+    assert(thrown);
+    assert(out.str().empty());
+
+    //маршрут от или до неизвестной остановки не найден, остальные ответы на месте
+    const string unknown_stops = MakeTestInput(1000, R"([
+        {"id": 1, "type": "Route", "from": "A", "to": "Nowhere"},
+        {"id": 2, "type": "Route", "from": "Nowhere", "to": "A", "max_vertices": 100},
+        {"id": 3, "type": "Route", "from": "A", "to": "C"}])"sv);
+    for(auto mode : {ctlg::jreader::InputMode::DOCUMENT, ctlg::jreader::InputMode::STREAM}){
+        const json::Array answers = json::Load(GetTestStats(unknown_stops, mode)).GetRoot().AsArray();
+        assert(answers.size() == 3);
+        for(size_t i = 0; i < 2; ++i){
+            assert(answers[i].AsDict().at("request_id"s).AsInt() == static_cast<int>(i + 1));
+            assert(answers[i].AsDict().at("error_message"s).AsString() == "not found"s);
+        }
+        assert(answers[2].AsDict().count("total_time"s));
+    }
+    auto catalogue_ptr = std::make_unique<TransportCatalogue>();
+    RequestHandler snapshot_handler{*catalogue_ptr};
+    ctlg::jreader::JsonReader snapshot_reader(snapshot_handler, string_view{unknown_stops});
+    snapshot_reader.ApplyCommands();
+    const CatalogueSnapshot snapshot(std::move(catalogue_ptr), snapshot_reader.GetRoutingSettings(),
+                                     snapshot_reader.GetRendererSettings());
+    const json::Array snapshot_answers = json::Load(snapshot_reader.GetStats(snapshot)).GetRoot().AsArray();
+    assert(snapshot_answers[0].AsDict().at("error_message"s).AsString() == "not found"s);
+    assert(snapshot_answers[1].AsDict().at("error_message"s).AsString() == "not found"s);
+}
+
+//снимок справочника MakeTestInput(ab_distance)
+std::shared_ptr<const CatalogueSnapshot> MakeTestSnapshot(int ab_distance){
+    auto catalogue = std::make_unique<TransportCatalogue>();
+    RequestHandler handler{*catalogue};
+    const string input = MakeTestInput(ab_distance);
+    ctlg::jreader::JsonReader jreader(handler, string_view{input});
+    jreader.ApplyCommands();
+    return std::make_shared<const CatalogueSnapshot>(std::move(catalogue), jreader.GetRoutingSettings(),
+                                                     jreader.GetRendererSettings());
+}
+
+void TestCatalogueSnapshot(){
+    SnapshotHolder holder;
+    assert(!holder.Get());
+    holder.Publish(MakeTestSnapshot(1000));
+    std::shared_ptr<const CatalogueSnapshot> held = holder.Get();
+    assert(held && held->GetCatalogue().IsFrozen());
+    const Bus* bus = held->GetCatalogue().GetBus("1"sv);
+    assert(bus && held->GetCatalogue().GetBusStat(*bus).lenght == 5000);
+
+    //карта отрисовывается один раз, сколько бы потоков её ни запросили
+    assert(!held->GetRenderedMap());
+    vector<std::future<const string*>> readers;
+    for(int i = 0; i < 4; ++i){
+        readers.push_back(std::async(std::launch::async, [held]{ return &held->GetMap(); }));
+    }
+    const string* map = &held->GetMap();
+    for(auto& reader : readers){
+        assert(reader.get() == map);
+    }
+    assert(held->GetRenderedMap() == map && !map->empty());
+
+    //новый снимок не меняет тот, что уже получен читателем
+    const auto old_route = held->GetRouter().CreateRoute("A"sv, "B"sv);
+    std::weak_ptr<const CatalogueSnapshot> old = held;
+    holder.Publish(MakeTestSnapshot(7000));
+    const auto current = holder.Get();
+    assert(current != held);
+    assert(current->GetCatalogue().GetBusStat(*current->GetCatalogue().GetBus("1"sv)).lenght == 17000);
+    assert(held->GetCatalogue().GetBusStat(*bus).lenght == 5000);
+    const auto route = held->GetRouter().CreateRoute("A"sv, "B"sv);
+    assert(old_route && route && route->total_time == old_route->total_time);
+    assert(current->GetRouter().CreateRoute("A"sv, "B"sv)->total_time > route->total_time);
+    assert(held->GetRenderedMap() == map && !current->GetRenderedMap());
+
+    //старый снимок освобождается вместе с последним читателем
+    assert(!old.expired());
+    held.reset();
+    assert(old.expired());
+}
+
+//ответ MemoryReport: у каждой части и у итога kib, allocations и mapped_kib, итог складывается из частей
+void CheckMemoryReportAnswer(const json::Dict& answer, const std::set<string>& expected_structures){
+    const std::set<string> keys{"kib"s, "allocations"s, "mapped_kib"s};
+    auto key_set = [](const json::Dict& dict){
+        std::set<string> result;
+        for(const auto& [key, value] : dict){
+            result.insert(key);
+        }
+        return result;
+    };
+    const json::Dict& total = answer.at("total"s).AsDict();
+    assert(key_set(total) == keys);
+    const json::Dict& structures = answer.at("structures"s).AsDict();
+    assert(key_set(structures) == expected_structures);
+    int kib = 0;
+    int max_kib = 0;
+    int allocations = 0;
+    for(const auto& [name, usage] : structures){
+        assert(key_set(usage.AsDict()) == keys);
+        kib += usage.AsDict().at("kib"s).AsInt();
+        max_kib = std::max(max_kib, usage.AsDict().at("kib"s).AsInt());
+        allocations += usage.AsDict().at("allocations"s).AsInt();
+    }
+    //части округляются до КиБ вверх по отдельности
+    assert(total.at("kib"s).AsInt() <= kib && total.at("kib"s).AsInt() >= max_kib);
+    assert(total.at("allocations"s).AsInt() == allocations);
+    assert(structures.at("catalogue.stops"s).AsDict().at("kib"s).AsInt() > 0);
+    assert(structures.at("router"s).AsDict().at("kib"s).AsInt() > 0);
+}
+
+void TestMemoryReport(){
+    MemoryReport report;
+    report.Add("a"s, {1500, 2, 0});
+    report.Add("a"s, {100, 1, 0});
+    report.Add("b"s, {10, 1, 4096});
+    assert(report.GetItems().size() == 2);
+    assert(report.GetItems().at("a"s).bytes == 1600 && report.GetItems().at("a"s).allocations == 3);
+    const MemoryUsage total = report.GetTotal();
+    assert(total.bytes == 1610 && total.allocations == 4 && total.mapped_bytes == 4096);
+
+    const json::Node report_json = ctlg::jreader::JsonReader::MemoryReportToJson(report);
+    const json::Node expected = json::Builder{}.StartDict()
+        .Key("total"s).StartDict().Key("kib"s).Value(2).Key("allocations"s).Value(4).Key("mapped_kib"s).Value(4).EndDict()
+        .Key("structures"s).StartDict()
+            .Key("a"s).StartDict().Key("kib"s).Value(2).Key("allocations"s).Value(3).Key("mapped_kib"s).Value(0).EndDict()
+            .Key("b"s).StartDict().Key("kib"s).Value(1).Key("allocations"s).Value(1).Key("mapped_kib"s).Value(4).EndDict()
+        .EndDict()
+        .EndDict().Build();
+    assert(report_json == expected);
+
+    std::set<string> structures{"catalogue.buses"s, "catalogue.distances"s, "catalogue.name_indexes"s,
+        "catalogue.names"s, "catalogue.stop_buses"s, "catalogue.stops"s, "catalogue.stops_grid"s,
+        "graph"s, "json.document"s, "json.input"s, "router"s};
+    const string requests = R"([{"id": 1, "type": "MemoryReport"}, {"id": 2, "type": "Map"},
+                                {"id": 3, "type": "MemoryReport"}])"s;
+    const string input = MakeTestInput(1000, requests);
+    //карта попадает в отчёт, только когда уже отрисована
+    const json::Array answers = json::Load(GetTestStats(input, ctlg::jreader::InputMode::DOCUMENT)).GetRoot().AsArray();
+    assert(answers[0].AsDict().at("request_id"s).AsInt() == 1);
+    CheckMemoryReportAnswer(answers[0].AsDict(), structures);
+
+    auto catalogue = std::make_unique<TransportCatalogue>();
+    RequestHandler handler{*catalogue};
+    ctlg::jreader::JsonReader jreader(handler, string_view{input});
+    jreader.ApplyCommands();
+    const CatalogueSnapshot snapshot(std::move(catalogue), jreader.GetRoutingSettings(),
+                                     jreader.GetRendererSettings());
+    const json::Array snapshot_answers = json::Load(jreader.GetStats(snapshot)).GetRoot().AsArray();
+    CheckMemoryReportAnswer(snapshot_answers[0].AsDict(), structures);
+
+    structures.insert("svg.map"s);
+    CheckMemoryReportAnswer(answers[2].AsDict(), structures);
+    CheckMemoryReportAnswer(snapshot_answers[2].AsDict(), structures);
+    assert(snapshot_answers[2].AsDict().at("structures"s).AsDict().at("svg.map"s).AsDict().at("kib"s).AsInt()
+           == static_cast<int>((snapshot.GetMap().capacity() + 1 + 1023) / 1024));
+}
+
 void TestsStart(){
     // TestSphereProjector();
     // TestRenderRoutes();
     // TestSimpleGraphCrearion();
+    TestSearchBudget();
+    TestDistanceTable();
+    TestNameIndex();
+    TestSpatialGrid();
+    TestMapViewport();
+    TestRouteIterator();
+    TestNameIndexUpdates();
+    TestSpatialGridUpdates();
+    TestIncrementalIndexes();
+    TestCatalogueImage();
+    TestRoutesAttach();
+    TestJsonNumbers();
+    TestJsonEscapes();
+    TestDuplicateKeys();
+    TestUnsignedDecode();
+    TestLoadRootArray();
+    TestWriter();
+    TestStreamingWriter();
+    TestStatsWithBadRequest();
+    TestCatalogueSnapshot();
+    TestMemoryReport();
     TestGraphBuilding0();
     // TestGraphBuilding1();
 }
\ No newline at end of file
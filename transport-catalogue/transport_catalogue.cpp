@@ -1,118 +1,308 @@
 #include <algorithm>
+#include <future>
 #include <set>
 #include <stdexcept>
+#include <thread>
 #include "transport_catalogue.h"
 
 namespace ctlg{
 
 void TransportCatalogue::AddStop(const Stop& stop){
     all_stops_.push_back(std::move(stop));
-    stops_index_.insert({all_stops_.back().name_, &all_stops_.back()});
+    Stop& added = all_stops_.back();
+    added.id_ = static_cast<StopId>(all_stops_.size() - 1);
+    added.name_ = names_.Store(added.name_);
+    stops_index_.insert({added.name_, added.id_});
+    stop_buses_.emplace_back();
+    stop_points_.Add(added.coord_);
+    if(frozen_){
+        frozen_stops_index_.Insert(added.name_, added.id_, [this](uint32_t id){ return all_stops_[id].name_; });
+        stops_grid_.Insert(added.id_, added.coord_);
+    }
 }
 
-Stop* TransportCatalogue::GetStop(std::string_view stop_name) const{
-    if(stops_index_.count(stop_name) == 0){
-        return nullptr;
+std::optional<StopId> TransportCatalogue::FindStopId(std::string_view stop_name) const{
+    if(frozen_){
+        return frozen_stops_index_.Find(stop_name, [this](uint32_t id){ return all_stops_[id].name_; });
+    }
+    auto it = stops_index_.find(stop_name);
+    if(it == stops_index_.end()){
+        return std::nullopt;
     }
-    return stops_index_.at(stop_name);
+    return it->second;
+}
+
+const Stop* TransportCatalogue::GetStop(std::string_view stop_name) const{
+    auto id = FindStopId(stop_name);
+    return id ? &all_stops_[*id] : nullptr;
 }
 
 void TransportCatalogue::AddBus(const Bus& bus){
     all_buses_.push_back(std::move(bus));
-    auto& bus_name = all_buses_.back().name_;
-    buses_index_.insert({bus_name, &all_buses_.back()});
+    Bus& added = all_buses_.back();
+    added.id_ = static_cast<BusId>(all_buses_.size() - 1);
+    added.name_ = names_.Store(added.name_);
+    added.stat_.reset();
+    BuildBusDistances(added);
+    buses_index_.insert({added.name_, added.id_});
+    AddBusToStops(added);
+    if(frozen_){
+        frozen_buses_index_.Insert(added.name_, added.id_, [this](uint32_t id){ return all_buses_[id].name_; });
+    }
+    changes_.routes = changes_.map = true;
+}
+
+bool TransportCatalogue::RemoveBus(string_view bus_name){
+    auto it = buses_index_.find(bus_name);
+    if(it == buses_index_.end()){
+        return false;
+    }
+    Bus& bus = all_buses_[it->second];
+    for(StopId stop : bus.stops_){
+        vector<string_view>& buses = stop_buses_[stop];
+        auto pos = std::lower_bound(buses.begin(), buses.end(), bus.name_);
+        if(pos != buses.end() && *pos == bus.name_){
+            buses.erase(pos);
+        }
+    }
+    buses_index_.erase(it);
+    if(frozen_){
+        frozen_buses_index_.Erase(bus.name_, bus.id_);
+    }
+    bus.removed_ = true;
+    bus.stops_.clear();
+    bus.road_prefix_.clear();
+    bus.geo_prefix_.clear();
+    bus.road_back_prefix_.clear();
+    bus.stat_.reset();
+    changes_.routes = changes_.map = true;
+    return true;
+}
+
+void TransportCatalogue::MoveStop(string_view stop_name, geo::Coordinates coord){
+    auto id = FindStopId(stop_name);
+    if(!id){
+        throw std::runtime_error("TransportCatalogue::MoveStop: Unknown stop name.");
+    }
+    Stop* stop = &all_stops_[*id];
+    stop->coord_ = coord;
+    stop_points_.Set(stop->id_, coord);
+    RefreshStopBuses(stop->id_);
+    if(frozen_){
+        stops_grid_.Move(stop->id_, coord);
+    }
+    changes_.map = true;
 }
 
-Bus* TransportCatalogue::GetBus(std::string_view bus_name) const{
-    if(buses_index_.count(bus_name) == 0){
-        return nullptr;
+CatalogueChanges TransportCatalogue::TakeChanges(){
+    CatalogueChanges changes = changes_;
+    changes_ = {};
+    return changes;
+}
+
+void TransportCatalogue::AddBusToStops(const Bus& bus){
+    string_view bus_name = bus.name_;
+    for(StopId stop : bus.stops_){
+        vector<string_view>& buses = stop_buses_[stop];
+        auto it = std::lower_bound(buses.begin(), buses.end(), bus_name);
+        if(it == buses.end() || *it != bus_name){
+            buses.insert(it, bus_name);
+        }
     }
-    return buses_index_.at(bus_name);
+}
+
+BusNamesRange TransportCatalogue::GetStopBusesRange(const Stop& stop) const{
+    return ranges::AsRange(stop_buses_[stop.id_]);
+}
+
+std::optional<BusId> TransportCatalogue::FindBusId(std::string_view bus_name) const{
+    if(frozen_){
+        return frozen_buses_index_.Find(bus_name, [this](uint32_t id){ return all_buses_[id].name_; });
+    }
+    auto it = buses_index_.find(bus_name);
+    if(it == buses_index_.end()){
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+const Bus* TransportCatalogue::GetBus(std::string_view bus_name) const{
+    auto id = FindBusId(bus_name);
+    return id ? &all_buses_[*id] : nullptr;
 }
 
 bool TransportCatalogue::ContainStop(string_view stop_name, const Bus&  bus) const{
-    for(auto stop : bus.stops_){
-        if(stop->name_ == stop_name){
+    for(StopId stop : bus.stops_){
+        if(all_stops_[stop].name_ == stop_name){
             return true;
         }
     }
     return false;
 }
 
-std::pair<size_t,double> TransportCatalogue::CalcUniqueStopsAndRouteLenght(const Bus& bus) const{
-    std::set<std::string_view> uniques;
-    double L = 0.0;
-    for(size_t i = 0; i < bus.stops_.size(); ++i){
-        uniques.insert(bus.stops_[i]->name_);
-        if(i > 0){
-            const Stop *s1 = bus.stops_[i - 1];
-            const Stop *s2 = bus.stops_[i];
-            L += geo::ComputeDistance(s1->coord_, s2->coord_);
+size_t TransportCatalogue::CalcUniqueStops(const Bus& bus) const{
+    std::set<StopId> uniques(bus.stops_.begin(), bus.stops_.end());
+    return uniques.size();
+}
+
+//накопленные суммы расстояний вдоль маршрута; отсутствующее расстояние считается нулевым
+void TransportCatalogue::BuildBusDistances(Bus& bus){
+    const size_t n = bus.stops_.size();
+    bus.road_prefix_.assign(n, 0);
+    bus.geo_prefix_.assign(n, 0.0);
+    bus.road_back_prefix_.assign(bus.IsRound() ? 0 : n, 0);
+    vector<double>& segments = segment_lengths_;
+    segments.resize(n > 0 ? n - 1 : 0);
+    stop_points_.ComputeSegments(bus.stops_.data(), n, segments.data(), segment_scratch_);
+    for(size_t i = 1; i < n; ++i){
+        bus.road_prefix_[i] = bus.road_prefix_[i - 1] + distances_.Get(bus.stops_[i - 1], bus.stops_[i]).value_or(0);
+        bus.geo_prefix_[i] = bus.geo_prefix_[i - 1] + segments[i - 1];
+        if(!bus.IsRound()){
+            bus.road_back_prefix_[i] = bus.road_back_prefix_[i - 1] + distances_.Get(bus.stops_[i], bus.stops_[i - 1]).value_or(0);
         }
     }
-    return {uniques.size(), L};
 }
 
 vector<string_view> TransportCatalogue::GetStopBuses(string_view stop_name) const{
-    vector<string_view> buses;
-    if(stops_index_.count(stop_name) == 0){
+    const Stop* stop = GetStop(stop_name);
+    if(!stop){
         std::string msg{"invalid bus stop name: "};
         msg += stop_name;
         throw std::invalid_argument(msg);
     }
-    for(const auto& bus : all_buses_){
-        if(ContainStop(stop_name, bus)){
-            buses.push_back(bus.name_);
-        }
-    }
-    std::sort(buses.begin(), buses.end());
-    return buses;
+    BusNamesRange buses = GetStopBusesRange(*stop);
+    return {buses.begin(), buses.end()};
 }
 
 void TransportCatalogue::SetDistance(string_view stop_from_name, string_view stop_to_name, int dist){
-    Stop* stop_from{GetStop(stop_from_name)};
-    Stop* stop_to{GetStop(stop_to_name)};
+    const Stop* stop_from{GetStop(stop_from_name)};
+    const Stop* stop_to{GetStop(stop_to_name)};
     if(!stop_from || !stop_to){
         throw std::runtime_error("TransportCatalogue::SetDistance: Unknown stop name.");
     }
-    StopPair key{stop_from, stop_to};
-    distances_[key] = dist;
+    SetDistance(stop_from->id_, stop_to->id_, dist);
 }
 
-int  TransportCatalogue::GetDistance(Stop* from, Stop* to){
-    if(distances_.count({from,to}) > 0){
-        return distances_.at({from,to});
+void TransportCatalogue::SetDistance(StopId stop_from, StopId stop_to, int dist){
+    distances_.Set(stop_from, stop_to, dist);
+    RefreshStopBuses(stop_from);
+    RefreshStopBuses(stop_to);
+    changes_.routes = true;
+}
+
+//пересчитывает расстояния и сбрасывает статистику автобусов, проходящих через stop
+void TransportCatalogue::RefreshStopBuses(StopId stop){
+    for(string_view bus_name : stop_buses_[stop]){
+        Bus& bus = all_buses_[buses_index_.at(bus_name)];
+        BuildBusDistances(bus);
+        bus.stat_.reset();
     }
-    if(distances_.count({to,from}) > 0){
-        return distances_.at({to,from});
+}
+
+BusStat TransportCatalogue::CalcBusStat(const Bus& bus) const{
+    const size_t count = bus.GetRouteStopCount();
+    const size_t last = count == 0 ? 0 : count - 1;
+    return {bus.name_, count, CalcUniqueStops(bus),
+            bus.GetGeoDistance(0, last), bus.GetRoadDistance(0, last)};
+}
+
+BusStat TransportCatalogue::GetBusStat(const Bus& bus) const{
+    if(bus.stat_){
+        return *bus.stat_;
     }
-    return -1;
+    return CalcBusStat(bus);
 }
 
-int TransportCatalogue::GetRouteLenght(const Bus& bus) const{
-    int L = 0;
-    for(size_t i = 0; i < bus.stops_.size() - 1; ++i){
-        StopPair key{bus.stops_[i], bus.stops_[i+1]};
-        if(distances_.count(key)){
-            L += distances_.at(key);
-        } else {
-            StopPair back{bus.stops_[i+1], bus.stops_[i]};
-            if(distances_.count(back)){
-                L += distances_.at(back);
+//пересчитывает сброшенную статистику маршрутов, распределяя автобусы по потокам
+void TransportCatalogue::UpdateBusStats(){
+    vector<Bus*> stale;
+    for(Bus& bus : all_buses_){
+        if(!bus.stat_ && !bus.removed_){
+            stale.push_back(&bus);
+        }
+    }
+    if(stale.empty()){
+        return;
+    }
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunk = (stale.size() + threads - 1) / threads;
+    vector<std::future<void>> tasks;
+    for(size_t begin = 0; begin < stale.size(); begin += chunk){
+        const size_t end = std::min(begin + chunk, stale.size());
+        tasks.push_back(std::async(std::launch::async, [this, &stale, begin, end]{
+            for(size_t i = begin; i < end; ++i){
+                stale[i]->stat_ = CalcBusStat(*stale[i]);
             }
+        }));
+    }
+    for(auto& task : tasks){
+        task.get();
+    }
+}
+
+void TransportCatalogue::Freeze(){
+    vector<std::pair<string_view, uint32_t>> entries;
+    entries.reserve(all_stops_.size());
+    for(const Stop& stop : all_stops_){
+        entries.push_back({stop.name_, stop.id_});
+    }
+    frozen_stops_index_.Build(entries);
+    entries.clear();
+    for(const Bus& bus : all_buses_){
+        if(!bus.removed_){
+            entries.push_back({bus.name_, bus.id_});
         }
     }
-    return L;
+    frozen_buses_index_.Build(entries);
+    vector<geo::Coordinates> coords;
+    coords.reserve(all_stops_.size());
+    for(const Stop& stop : all_stops_){
+        coords.push_back(stop.coord_);
+    }
+    stops_grid_.Build(coords);
+    frozen_ = true;
 }
 
-BusStat TransportCatalogue::GetBusStat(const Bus& bus) const{
-    auto [unique, length_geo] = CalcUniqueStopsAndRouteLenght(bus);
-    int length = GetRouteLenght(bus);
-    return {bus.name_, bus.stops_.size(), unique, length_geo, length};
+vector<std::pair<const Stop*, double>> TransportCatalogue::GetNearestStops(geo::Coordinates point, size_t count) const{
+    vector<std::pair<const Stop*, double>> result;
+    if(frozen_){
+        for(auto [id, dist] : stops_grid_.FindNearest(point, count)){
+            result.push_back({&all_stops_[id], dist});
+        }
+        return result;
+    }
+    //без сетки - полный перебор
+    for(const Stop& stop : all_stops_){
+        result.push_back({&stop, geo::ComputeDistance(point, stop.coord_)});
+    }
+    auto nearer = [](const auto& lhs, const auto& rhs){
+        return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first->id_ < rhs.first->id_);
+    };
+    count = std::min(count, result.size());
+    std::partial_sort(result.begin(), result.begin() + count, result.end(), nearer);
+    result.resize(count);
+    return result;
+}
+
+vector<const Stop*> TransportCatalogue::GetStopsInArea(geo::Coordinates min, geo::Coordinates max) const{
+    vector<const Stop*> result;
+    if(frozen_){
+        for(uint32_t id : stops_grid_.FindInArea(min, max)){
+            result.push_back(&all_stops_[id]);
+        }
+        return result;
+    }
+    for(const Stop& stop : all_stops_){
+        const geo::Coordinates& p = stop.coord_;
+        if(p.lat >= min.lat && p.lat <= max.lat && p.lng >= min.lng && p.lng <= max.lng){
+            result.push_back(&stop);
+        }
+    }
+    return result;
 }
 
 StopStat TransportCatalogue::GetStopStat(const Stop& stop) const{
-    return {stop.name_, GetStopBuses(stop.name_)};
+    return {stop.name_, GetStopBusesRange(stop)};
 }
 
 vector<string_view>  TransportCatalogue::GetBuses() const {
@@ -132,12 +322,31 @@ vector<string_view> TransportCatalogue::GetBusesUnordered() const {
     return bus_names;
 }
 
-int TransportCatalogue::GetDistance(Stop* from, Stop* to) const{
-    if(distances_.count({from, to})){
-        return distances_.at({from, to});
+void TransportCatalogue::GetMemoryUsage(MemoryReport& report) const{
+    report.Add("catalogue.names", names_.GetMemoryUsage());
+    if(image_){
+        report.Add("catalogue.image", {0, 0, image_->Size()});
+    }
+    report.Add("catalogue.stops", UsageOf(all_stops_) + stop_points_.GetMemoryUsage());
+    MemoryUsage buses = UsageOf(all_buses_);
+    for(const Bus& bus : all_buses_){
+        buses += UsageOf(bus.stops_) + UsageOf(bus.road_prefix_) + UsageOf(bus.geo_prefix_) + UsageOf(bus.road_back_prefix_);
     }
-    if(distances_.count({to,from})){
-        return distances_.at({to,from});
+    report.Add("catalogue.buses", buses);
+    report.Add("catalogue.name_indexes", UsageOf(stops_index_) + UsageOf(buses_index_)
+                                         + frozen_stops_index_.GetMemoryUsage() + frozen_buses_index_.GetMemoryUsage());
+    report.Add("catalogue.stops_grid", stops_grid_.GetMemoryUsage());
+    report.Add("catalogue.distances", distances_.GetMemoryUsage());
+    MemoryUsage stop_buses = UsageOf(stop_buses_);
+    for(const vector<string_view>& buses : stop_buses_){
+        stop_buses += UsageOf(buses);
+    }
+    report.Add("catalogue.stop_buses", stop_buses);
+}
+
+int TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const{
+    if(auto dist = distances_.Get(from->id_, to->id_)){
+        return *dist;
     }
     if(to == from){
         return 0.0;
@@ -1,6 +1,7 @@
 #pragma once
 #include <cassert>
 #include <deque>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -8,8 +9,14 @@
 #include <unordered_map>
 #include <vector>
 
+#include "distance_table.h"
 #include "domain.h"
 #include "graph.h"
+#include "mapped_file.h"
+#include "memory_usage.h"
+#include "name_arena.h"
+#include "name_index.h"
+#include "spatial_index.h"
 // #include "geo.h"
 
 
@@ -17,44 +24,85 @@ namespace ctlg{
 
 using std::string, std::string_view, std::vector;
 
+// Какие производные данные устарели после изменений справочника
+struct CatalogueChanges {
+    //автобусы или дорожные расстояния: граф маршрутов
+    bool routes = false;
+    //автобусы или координаты остановок: карта
+    bool map = false;
+};
+
 class TransportCatalogue {
 public:
-    using StopPair = std::pair<Stop*, Stop*>;
-    
 	void AddStop(const Stop& stop);
-	Stop* GetStop(string_view stop_name) const;
+	const Stop* GetStop(string_view stop_name) const;
+    const Stop& GetStop(StopId id) const { return all_stops_[id]; }
 	void AddBus(const Bus& bus);
-	Bus* GetBus(string_view bus_name) const;
+    //возвращает false, если автобуса с таким именем нет
+    bool RemoveBus(string_view bus_name);
+    void MoveStop(string_view stop_name, geo::Coordinates coord);
+    //накопленные с прошлого вызова изменения
+    CatalogueChanges TakeChanges();
+	const Bus* GetBus(string_view bus_name) const;
+    const Bus& GetBus(BusId id) const { return all_buses_[id]; }
     vector<string_view> GetStopBuses(string_view stop_name) const;
     bool ContainStop(string_view stop_name, const Bus&  bus) const;
     void SetDistance(string_view stop_from_name, string_view stop_to_name, int dist);
-    int  GetDistance(Stop* from, Stop* to);
+    void SetDistance(StopId stop_from, StopId stop_to, int dist);
     // RouteInfo GetRouteInfo(const Bus& bus) const;
     BusStat GetBusStat(const Bus& bus) const;
+    void UpdateBusStats();
+    //строит компактные индексы имён и сетку остановок; последующие изменения
+    //справочника правят их точечно, без перестройки
+    void Freeze();
+    bool IsFrozen() const { return frozen_; }
+    //до count ближайших к point остановок с расстояниями, по возрастанию расстояния
+    vector<std::pair<const Stop*, double>> GetNearestStops(geo::Coordinates point, size_t count) const;
+    //остановки внутри прямоугольника координат, по возрастанию id
+    vector<const Stop*> GetStopsInArea(geo::Coordinates min, geo::Coordinates max) const;
     StopStat GetStopStat(const Stop& stop) const;
     vector<string_view> GetBuses() const;
     vector<string_view> GetBusesUnordered() const;
     const std::deque<Stop>& GetAllStops() const {return all_stops_;}
     inline const std::deque<Bus>& GetAllBuses() const {return all_buses_;}
-    int GetDistance(Stop* from, Stop* to) const;
+    int GetDistance(const Stop* from, const Stop* to) const;
     void CreateGraph( const RoutingSettings& rs);
+    //добавляет в report части справочника под именами catalogue.*
+    void GetMemoryUsage(MemoryReport& report) const;
     // GraphInfo CreateGraph(const RoutingSettings& rs, string_view from, string_view to);
 private:
+    friend class CatalogueImage;
 
-    struct PairPointerHasher{
-        size_t operator()(const StopPair& elem) const {
-            return (size_t)(elem.first) + 37 * (size_t)(elem.second);
-        }
-    };
-
+    NameArena names_;
+    //образ, в который смотрят имена загруженного из него справочника
+    std::shared_ptr<const MappedFile> image_;
 	std::deque<Stop> all_stops_;
-	std::unordered_map<std::string_view, Stop*>stops_index_;
+	std::unordered_map<std::string_view, StopId>stops_index_;
 	std::deque<Bus> all_buses_;
-	std::unordered_map<std::string_view, Bus*> buses_index_;
-    std::unordered_map<StopPair,int,PairPointerHasher> distances_;
+	std::unordered_map<std::string_view, BusId> buses_index_;
+    FrozenNameIndex frozen_stops_index_;
+    FrozenNameIndex frozen_buses_index_;
+    //сетка по координатам остановок, строится в Freeze()
+    geo::GridIndex stops_grid_;
+    bool frozen_ = false;
+    CatalogueChanges changes_;
+    DistanceTable distances_;
+    //координаты остановок по StopId для пакетного расчёта расстояний
+    geo::PointsSoA stop_points_;
+    //рабочие массивы BuildBusDistances, чтобы не выделять их на каждый автобус
+    geo::SegmentScratch segment_scratch_;
+    vector<double> segment_lengths_;
+    //id остановки -> отсортированные имена проходящих через неё автобусов
+    vector<vector<string_view>> stop_buses_;
 
-    std::pair<size_t,double> CalcUniqueStopsAndRouteLenght(const Bus& bus) const;
-    int GetRouteLenght(const Bus& bus) const;
+    std::optional<StopId> FindStopId(string_view stop_name) const;
+    std::optional<BusId> FindBusId(string_view bus_name) const;
+    size_t CalcUniqueStops(const Bus& bus) const;
+    void BuildBusDistances(Bus& bus);
+    void AddBusToStops(const Bus& bus);
+    void RefreshStopBuses(StopId stop);
+    BusStat CalcBusStat(const Bus& bus) const;
+    BusNamesRange GetStopBusesRange(const Stop& stop) const;
 };
 
 } //ctlg
\ No newline at end of file
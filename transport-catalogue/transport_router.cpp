@@ -1,29 +1,74 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "checksum.h"
 #include "transport_router.h"
 
-size_t transport_router::GetStopVertexW(const Stop* stop) const {
-    return stops_indexes_.at(stop) * 2;
+namespace {
+
+using namespace std::literals;
+
+// Заголовок файла таблицы маршрутов; за ним следуют vertex_count^2 ячеек Router<double>::RouteCell
+struct RoutesFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t cell_size;
+    uint64_t vertex_count;
+    uint64_t edge_count;
+    double bus_wait_time;
+    double bus_velocity;
+    //сумма по концам, пересадкам и весам всех рёбер графа, для которого построена таблица
+    uint64_t graph_fingerprint;
+    //сумма по ячейкам таблицы
+    uint64_t table_checksum;
+};
+
+constexpr char ROUTES_MAGIC[8] = {'T', 'C', 'R', 'O', 'U', 'T', 'E', 'S'};
+constexpr uint32_t ROUTES_VERSION = 2;
+
+using RouteCell = graph::Router<double>::RouteCell;
+static_assert(std::is_trivially_copyable_v<RouteCell>);
+static_assert(sizeof(RoutesFileHeader) % alignof(RouteCell) == 0);
+static_assert(sizeof(RouteCell) % 8 == 0);
+
+// Таблица с теми же числами вершин и рёбер, но от справочника с другими расстояниями,
+// дала бы неверные маршруты, поэтому таблица привязывается к весам рёбер
+template <typename Graph>
+uint64_t GetGraphFingerprint(const Graph& graph) {
+    uint64_t hash = ctlg::CHECKSUM_SEED;
+    for(graph::EdgeId id = 0; id < graph.GetEdgeCount(); ++id){
+        const auto& edge = graph.GetEdge(id);
+        uint64_t weight;
+        std::memcpy(&weight, &edge.weight, sizeof(weight));
+        hash = ctlg::MixChecksum(hash, edge.from);
+        hash = ctlg::MixChecksum(hash, edge.to);
+        hash = ctlg::MixChecksum(hash, edge.span_count);
+        hash = ctlg::MixChecksum(hash, weight);
+    }
+    return hash;
 }
 
-size_t transport_router::GetGraphSize(){
-    return catalogue_.GetAllStops().size() * 2;
+} //namespace
+
+size_t transport_router::GetStopVertexW(StopId stop) const {
+    return stop * 2;
 }
 
-void transport_router::CreateStopIndexes(){
-    stops_indexes_.clear();
-    for(size_t i = 0; i < catalogue_.GetAllStops().size(); ++i){
-        stops_indexes_[&catalogue_.GetAllStops()[i]] = i;
-    }
+size_t transport_router::GetGraphSize(){
+    return catalogue_.GetAllStops().size() * 2;
 }
 
 transport_router::BusGraph transport_router::BuildGraph() const{
     const std::deque<Bus>& buses = catalogue_.GetAllBuses();
     //i * 2 - вершина начала ожидания wait для остановки i. i * 2 + 1 - вершина остановки после ожидания, и т.д.
-    //где i - индекс в all_stops_
+    //где i - id остановки
     size_t N = catalogue_.GetAllStops().size() * 2;
     BusGraph graph(N);
     //stopW -> stop
     for(const Stop& stop : catalogue_.GetAllStops()){
-        graph::VertexId vertexW = GetStopVertexW(&stop);
+        graph::VertexId vertexW = GetStopVertexW(stop.id_);
         graph::VertexId vertex = vertexW + 1;
         graph.AddEdge({vertexW, vertex, stop.name_, 0, (double)rs_.bus_wait_time});
     }
@@ -42,25 +87,93 @@ void transport_router::CreateRouter(){
 }
 
 void transport_router::CreateAllData(){
-    CreateStopIndexes();
     graph_ = BuildGraph();
     CreateRouter();
+    routes_file_.reset();
+}
+
+void transport_router::GetMemoryUsage(MemoryReport& report) const{
+    if(graph_){
+        report.Add("graph", graph_->GetMemoryUsage());
+    }
+    if(router_){
+        MemoryUsage usage = router_->GetMemoryUsage();
+        usage.mapped_bytes = routes_file_ ? routes_file_->Size() : 0;
+        report.Add("router", usage);
+    }
+}
+
+void transport_router::SaveRoutes(const std::string& path) const{
+    if(!router_){
+        throw std::logic_error("transport_router::SaveRoutes: routes are not built.");
+    }
+    RoutesFileHeader header{};
+    std::memcpy(header.magic, ROUTES_MAGIC, sizeof(ROUTES_MAGIC));
+    header.version = ROUTES_VERSION;
+    header.cell_size = sizeof(RouteCell);
+    header.vertex_count = graph_->GetVertexCount();
+    header.edge_count = graph_->GetEdgeCount();
+    header.bus_wait_time = rs_.bus_wait_time;
+    header.bus_velocity = rs_.bus_velocity;
+    const size_t table_size = header.vertex_count * header.vertex_count * sizeof(RouteCell);
+    header.graph_fingerprint = GetGraphFingerprint(*graph_);
+    header.table_checksum = ctlg::Checksum(reinterpret_cast<const char*>(router_->GetTable()), table_size);
+
+    const std::string tmp_path = path + ".tmp"s;
+    {
+        std::ofstream out(tmp_path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(router_->GetTable()), static_cast<std::streamsize>(table_size));
+        if(!out){
+            throw std::runtime_error("transport_router::SaveRoutes: write failed.");
+        }
+    }
+    if(std::rename(tmp_path.c_str(), path.c_str()) != 0){
+        throw std::runtime_error("transport_router::SaveRoutes: cannot rename "s + tmp_path);
+    }
+}
+
+void transport_router::AttachRoutes(const std::string& path){
+    auto file = std::make_unique<const MappedFile>(path);
+    BusGraph graph = BuildGraph();
+    RoutesFileHeader header;
+    if(file->Size() < sizeof(header)){
+        throw std::runtime_error("transport_router::AttachRoutes: file is too short.");
+    }
+    std::memcpy(&header, file->Data(), sizeof(header));
+    const size_t vertex_count = graph.GetVertexCount();
+    if(std::memcmp(header.magic, ROUTES_MAGIC, sizeof(ROUTES_MAGIC)) != 0
+       || header.version != ROUTES_VERSION || header.cell_size != sizeof(RouteCell)){
+        throw std::runtime_error("transport_router::AttachRoutes: not a routes file of this version.");
+    }
+    if(header.vertex_count != vertex_count || header.edge_count != graph.GetEdgeCount()
+       || header.bus_wait_time != rs_.bus_wait_time || header.bus_velocity != rs_.bus_velocity
+       || file->Size() != sizeof(header) + vertex_count * vertex_count * sizeof(RouteCell)
+       || header.graph_fingerprint != GetGraphFingerprint(graph)){
+        throw std::runtime_error("transport_router::AttachRoutes: routes were built for other data.");
+    }
+    //повреждённая ячейка могла бы увести восстановление маршрута за пределы рёбер графа
+    if(header.table_checksum != ctlg::Checksum(file->Data() + sizeof(header), file->Size() - sizeof(header))){
+        throw std::runtime_error("transport_router::AttachRoutes: checksum mismatch.");
+    }
+    graph_ = std::move(graph);
+    router_ = std::make_unique<graph::Router<double>>(
+        *graph_, reinterpret_cast<const RouteCell*>(file->Data() + sizeof(header)));
+    routes_file_ = std::move(file);
 }
 
 
 inline void transport_router::AddRoute(const Bus* bus, BusGraph& graph, size_t j, size_t k, double dist) const{
-    size_t vertex_fromW = GetStopVertexW(bus->stops_[j]);
+    size_t vertex_fromW = GetStopVertexW(bus->GetRouteStop(j));
     size_t vertex_from = vertex_fromW + 1;
-    size_t vertex_toW = GetStopVertexW(bus->stops_[k]);
+    size_t vertex_toW = GetStopVertexW(bus->GetRouteStop(k));
     graph.AddEdge({vertex_from, vertex_toW, bus->name_, (k>j)? k-j : j-k, dist / meters_per_minute_av});
 }
 
 void transport_router::AddRoundBus(const Bus* bus, BusGraph& graph) const{
     for(size_t j = 0; j < bus->stops_.size(); ++j){
-        double dist = 0.0;
         for(size_t k = j + 1; k < bus->stops_.size(); ++k){
-            dist += catalogue_.GetDistance(bus->stops_[k-1], bus->stops_[k]);
-            AddRoute(bus, graph, j, k, dist);
+            AddRoute(bus, graph, j, k, bus->GetRoadDistance(j, k));
         }
     }
 }
@@ -68,26 +181,32 @@ void transport_router::AddRoundBus(const Bus* bus, BusGraph& graph) const{
 void transport_router::AddPlainBus(const Bus* bus, BusGraph& graph) const{
     size_t last_stop_ind = bus->GetLastStopIndex();
     for(size_t j = 0; j < last_stop_ind; ++j){
-        double dist = 0.0;
         for(size_t k = j + 1; k <= last_stop_ind; ++k){
-            dist += catalogue_.GetDistance(bus->stops_[k-1], bus->stops_[k]);
-            AddRoute(bus, graph, j, k, dist);
+            AddRoute(bus, graph, j, k, bus->GetRoadDistance(j, k));
         }
     }
-    for(size_t j = last_stop_ind; j < bus->stops_.size(); ++j){
-        double dist = 0.0;
-        for(size_t k = j + 1; k < bus->stops_.size(); ++k){
-            dist += catalogue_.GetDistance(bus->stops_[k-1], bus->stops_[k]);
-            AddRoute(bus, graph, j, k, dist);
+    const size_t route_size = bus->GetRouteStopCount();
+    for(size_t j = last_stop_ind; j < route_size; ++j){
+        for(size_t k = j + 1; k < route_size; ++k){
+            AddRoute(bus, graph, j, k, bus->GetRoadDistance(j, k));
         }
     }
 }
 
 
 std::optional<transport_router::Route> transport_router::CreateRoute(string_view stop_from, string_view stop_to) const{
-    Stop* from = catalogue_.GetStop(stop_from);
-    Stop* to = catalogue_.GetStop(stop_to);
-    auto route_info = router_->BuildRoute(GetStopVertexW(from),GetStopVertexW(to));
+    graph::SearchBudget unlimited;
+    return CreateRoute(stop_from, stop_to, unlimited);
+}
+
+std::optional<transport_router::Route> transport_router::CreateRoute(string_view stop_from, string_view stop_to, graph::SearchBudget& budget) const{
+    const Stop* from = catalogue_.GetStop(stop_from);
+    const Stop* to = catalogue_.GetStop(stop_to);
+    //маршрута от или до неизвестной остановки нет
+    if(!from || !to){
+        return {};
+    }
+    auto route_info = router_->BuildRoute(GetStopVertexW(from->id_),GetStopVertexW(to->id_), budget);
     if(!route_info){
         return {};
     }
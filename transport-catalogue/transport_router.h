@@ -2,6 +2,8 @@
 
 #include <memory>
 #include <optional>
+#include <string>
+#include "mapped_file.h"
 #include "transport_catalogue.h"
 #include "graph.h"
 #include "router.h"
@@ -25,21 +27,30 @@ public:
     };
 
     void CreateAllData();
+    // Сохраняет построенную таблицу маршрутов в файл (например, на tmpfs), чтобы другие
+    // процессы подключили её через AttachRoutes. Файл появляется под именем path атомарно
+    void SaveRoutes(const std::string& path) const;
+    // Вместо CreateAllData: строит граф и подключает таблицу из файла, сохранённого
+    // для того же справочника с теми же настройками. Страницы таблицы общие для всех процессов
+    void AttachRoutes(const std::string& path);
+    //добавляет в report граф (graph) и таблицу маршрутов (router)
+    void GetMemoryUsage(MemoryReport& report) const;
+    //nullopt, если маршрута нет или одна из остановок неизвестна
     std::optional<Route> CreateRoute(string_view stop_from, string_view stop_to) const ;
+    std::optional<Route> CreateRoute(string_view stop_from, string_view stop_to, graph::SearchBudget& budget) const;
 
 private:
     const ctlg::TransportCatalogue& catalogue_;
     // const std::deque<Stop>& all_stops_;
     std::optional<transport_router::BusGraph> graph_;
     std::unique_ptr<graph::Router<double>> router_;
-    std::unordered_map<const Stop*, size_t> stops_indexes_;
+    std::unique_ptr<const MappedFile> routes_file_;
     RoutingSettings rs_;
     const double to_meters_per_minutes = 1000. / 60;
     double meters_per_minute_av;
-    size_t GetStopVertexW(const Stop* stop) const;
+    size_t GetStopVertexW(StopId stop) const;
     size_t GetGraphSize();
     BusGraph BuildGraph() const;
-    void CreateStopIndexes();
     void CreateRouter();
     void AddRoute(const Bus* bus, BusGraph& graph, size_t j, size_t k, double dist) const;
     void AddRoundBus(const Bus* bus, BusGraph& graph) const;